@@ -35,10 +35,6 @@
 actors_t actors;
 local_actors_t local_actors;
 
-static uint16_t            level_pos_x[16];
-static uint8_t             level_pos_y[16];
-static struct costume_cel *cel_data[16];
-
 // private functions
 static uint8_t get_free_local_id(void);
 static void activate_costume(uint8_t actor_id);
@@ -49,7 +45,7 @@ static uint8_t is_walk_to_done(uint8_t actor_id, uint8_t local_id);
 static uint8_t is_next_walk_to_point_reached(uint8_t actor_id, uint8_t local_id);
 static uint8_t is_point_reached(uint8_t local_id, uint8_t x, uint8_t y);
 static void stop_walking(uint8_t local_id);
-static void calculate_next_box_point(uint8_t local_id);
+static void plan_route(uint8_t local_id);
 static void calculate_step(uint8_t local_id);
 static void add_local_actor(uint8_t actor_id);
 static void remove_local_actor(uint8_t actor_id);
@@ -58,6 +54,10 @@ static void update_walk_direction(uint8_t local_id);
 static uint8_t turn_to_target_direction(uint8_t local_id);
 static uint8_t turn_to_direction(uint8_t local_id, uint8_t target_dir);
 static void turn(uint8_t local_id);
+static void update_draw_order(uint8_t local_id);
+static void resolve_level_cel(uint8_t local_id, uint8_t level);
+static void calculate_cel_layout(uint8_t local_id, uint8_t mirror);
+static void calculate_canvas(uint8_t local_id);
 
 //-----------------------------------------------------------------------------------------------
 
@@ -72,7 +72,8 @@ void actor_init(void)
   for (uint8_t i = 0; i < NUM_ACTORS; ++i) {
     actors.local_id[i] = 0xff;
     if (i < MAX_LOCAL_ACTORS) {
-      local_actors.global_id[i] = 0xff;
+      local_actors.global_id[i]  = 0xff;
+      local_actors.draw_order[i] = 0xff;
     }
   }
 }
@@ -231,13 +232,15 @@ void actor_place_at(uint8_t actor_id, uint8_t x, uint8_t y)
     local_actors.walk_step_y[local_id] = 0;
     local_actors.masking[local_id]     = walkbox_get_box_masking(cur_box);
     local_actors.walking[local_id]     = WALKING_STATE_STOPPED;
+    vm_signal_event(actor_id);
     
     update_walk_direction(local_id);
     
     actors.x[actor_id]                 = local_actors.walk_to_x[local_id];
     actors.y[actor_id]                 = local_actors.walk_to_y[local_id];
     actors.dir[actor_id]               = local_actors.walk_dir[local_id];
-  
+
+    update_draw_order(local_id);
     vm_update_actors();
   }
   else {
@@ -274,19 +277,17 @@ void actor_walk_to(uint8_t actor_id, uint8_t x, uint8_t y, uint8_t target_dir)
 
 void actor_walk_to_object(uint8_t actor_id, uint16_t object_id)
 {
-  SAVE_DS_AUTO_RESTORE
-
   if (!actor_is_in_current_room(actor_id)) {
     return;
   }
-  __auto_type object_hdr = vm_get_room_object_hdr(object_id);
-  if (!object_hdr) {
+  uint8_t local_object_id = vm_get_local_object_id(object_id);
+  if (local_object_id == 0xff) {
     return;
   }
 
-  uint8_t x             = object_hdr->walk_to_x;
-  uint8_t y             = (object_hdr->walk_to_y_and_preposition & 0x1f) << 2;
-  uint8_t obj_actor_dir = object_hdr->height_and_actor_dir & 0x03;
+  uint8_t x             = room_objects.walk_to_x[local_object_id];
+  uint8_t y             = (room_objects.walk_to_y_and_preposition[local_object_id] & 0x1f) << 2;
+  uint8_t obj_actor_dir = room_objects.actor_dir[local_object_id];
 
   walkbox_correct_position_to_closest_box(&x, &y);
   actor_walk_to(actor_id, x, y, obj_actor_dir);
@@ -351,6 +352,7 @@ void actor_next_step(uint8_t local_id)
   }
 
   do_step(actor_id, local_id);
+  update_draw_order(local_id);
 }
 
 void actor_start_animation(uint8_t local_id, uint8_t animation)
@@ -416,6 +418,18 @@ void actor_start_animation(uint8_t local_id, uint8_t animation)
     ++cel_level_last_cmd;
   }
 
+  // rebuild list of running cel levels with their current cels
+  __auto_type active_levels = local_actors.active_levels[local_id];
+  uint8_t num_active_levels = 0;
+  cel_level_cur_cmd = local_actors.cel_level_cur_cmd[local_id];
+  for (uint8_t level = 0; level < 16; ++level) {
+    if (cel_level_cur_cmd[level] != 0xff) {
+      active_levels[num_active_levels++] = level;
+      resolve_level_cel(local_id, level);
+    }
+  }
+  local_actors.num_active_levels[local_id] = num_active_levels;
+
   vm_update_actors();
 }
 
@@ -426,31 +440,28 @@ void actor_update_animation(uint8_t local_id)
   map_ds_resource(local_actors.res_slot[local_id]);
   __auto_type cel_level_cur_cmd  = local_actors.cel_level_cur_cmd[local_id];
   __auto_type cel_level_last_cmd = local_actors.cel_level_last_cmd[local_id];
-  for (uint8_t level = 0; level < 16; ++level) {
-    uint8_t cmd_offset = *cel_level_cur_cmd;
-    if (cmd_offset != 0xff) {
-      while (1) {
-        uint8_t last_cmd_offset = *cel_level_last_cmd;
-        if (cmd_offset == (last_cmd_offset & 0x7f)) {
-          if (!(last_cmd_offset & 0x80)) {
-            //debug_out("  loop to 0");
-            *cel_level_cur_cmd = 0;
-            if (cmd_offset != 0) {
-              redraw_needed = 1;
-            }
-          }
-          break;
-        }
-        else {
-          (*cel_level_cur_cmd)++;
-          //debug_out("  advance to next cmd %d", *cel_level_cur_cmd);
+  __auto_type active_levels      = local_actors.active_levels[local_id];
+  uint8_t num_active_levels      = local_actors.num_active_levels[local_id];
+  for (uint8_t i = 0; i < num_active_levels; ++i) {
+    uint8_t level           = active_levels[i];
+    uint8_t cmd_offset      = cel_level_cur_cmd[level];
+    uint8_t last_cmd_offset = cel_level_last_cmd[level];
+    if (cmd_offset == (last_cmd_offset & 0x7f)) {
+      if (!(last_cmd_offset & 0x80)) {
+        //debug_out("  loop to 0");
+        cel_level_cur_cmd[level] = 0;
+        if (cmd_offset != 0) {
+          resolve_level_cel(local_id, level);
           redraw_needed = 1;
-          break;
         }
       }
     }
-    ++cel_level_cur_cmd;
-    ++cel_level_last_cmd;
+    else {
+      cel_level_cur_cmd[level]++;
+      //debug_out("  advance to next cmd %d", cel_level_cur_cmd[level]);
+      resolve_level_cel(local_id, level);
+      redraw_needed = 1;
+    }
   }
   
   if (redraw_needed) {
@@ -461,6 +472,10 @@ void actor_update_animation(uint8_t local_id)
 /**
   * @brief Sorts all local actors by their y position and draws them to the backbuffer.
   *
+  * The canvases of all actors are calculated and their rrb chars reserved first. If a
+  * row runs out of rrb chars, the actors in the back get clipped instead of the ones in
+  * front, which are drawn last.
+  *
   * @note The function will change CS and DS and not restore them.
   */
 void actor_sort_and_draw_all(void)
@@ -468,32 +483,25 @@ void actor_sort_and_draw_all(void)
   MAP_CS_GFX
   gfx_reset_actor_drawing();
 
-  // sorting all local actors
-  uint8_t sorted_actors[MAX_LOCAL_ACTORS];
-  uint8_t num_local_actors = 0;
-  for (uint8_t i = 0; i < NUM_ACTORS; ++i) {
-    if (actors.local_id[i] != 0xff) {
-      sorted_actors[num_local_actors++] = i;
+  for (uint8_t i = 0; i < MAX_LOCAL_ACTORS; ++i) {
+    uint8_t local_id = local_actors.draw_order[i];
+    if (local_id == 0xff) {
+      break;
     }
-  }
-
-  for (uint8_t i = 0; i < num_local_actors; ++i) {
-    for (uint8_t j = 0; j < num_local_actors; ++j) {
-      uint8_t actor_id_i = sorted_actors[i];
-      uint8_t actor_id_j = sorted_actors[j];
-      if (actors.y[actor_id_i] < actors.y[actor_id_j]) {
-        uint8_t tmp = sorted_actors[i];
-        sorted_actors[i] = sorted_actors[j];
-        sorted_actors[j] = tmp;
-      }
+    if (actors.costume[local_actors.global_id[local_id]]) {
+      calculate_canvas(local_id);
+      gfx_reserve_actor_canvas(local_actors.canvas_x[local_id], local_actors.canvas_y[local_id],
+                               local_actors.canvas_width[local_id], local_actors.canvas_height[local_id]);
     }
   }
 
-  // iterate over all sorted actors and draw their current cels on all cel levels
-  for (uint8_t i = 0; i < num_local_actors; ++i) {
-    uint8_t global_id = sorted_actors[i];
-    if (actors.costume[global_id]) {
-      uint8_t local_id = actors.local_id[global_id];
+  // iterate over all local actors sorted by y and draw their current cels on all cel levels
+  for (uint8_t i = 0; i < MAX_LOCAL_ACTORS; ++i) {
+    uint8_t local_id = local_actors.draw_order[i];
+    if (local_id == 0xff) {
+      break;
+    }
+    if (actors.costume[local_actors.global_id[local_id]]) {
       actor_draw(local_id);
     }
   }
@@ -510,6 +518,7 @@ void actor_sort_and_draw_all(void)
   *
   * Drawing the actor is done in the following steps:
   * 1. Determine the bounding box for all cels of the actor, relative to the actor's position.
+  *    This is done by calculate_canvas for all actors before any of them is drawn.
   * 2. Allocate an empty canvas for the actor, if the actor is visible on screen.
   * 3. Draw all cels to the allocated canvas.
   * 4. Apply background and object maskings to the actor canvas.
@@ -527,80 +536,14 @@ void actor_draw(uint8_t local_id)
   pos_y <<= 1; // convert to pixel position
 
   uint8_t masking = local_actors.masking[local_id];
-  int16_t min_x   = 0x7fff;
-  int16_t min_y   = 0xff;
-  int16_t max_x   = 0;
-  int16_t max_y   = 0;
+  uint8_t mirror  = local_actors.cel_layout_mirror[local_id];
 
   map_ds_resource(local_actors.res_slot[local_id]);
-  __auto_type hdr = (struct costume_header *)RES_MAPPED;
-  __auto_type cel_level_cmd_ptr = local_actors.cel_level_cmd_ptr[local_id];
-  __auto_type cel_level_cur_cmd = local_actors.cel_level_cur_cmd[local_id];
-  __auto_type cel_level_table_offset = hdr->level_table_offsets;
-
-  // step 1: determine bounding box, relative position and image pointers for all cels
-  uint8_t mirror = actors.dir[global_id] == 0 && !(hdr->disable_mirroring_and_format & 0x80);
-  int16_t dx = -72;
-  int16_t dy = -100;
-
-  for (uint8_t level = 0; level < 16; ++level) {
-    //debug_out("level %d", level);
-    
-    uint8_t cmd_offset = *cel_level_cur_cmd;
-    cel_data[level] = NULL;
-
-    if (cmd_offset != 0xff) {
-      uint8_t *cmd_ptr = *cel_level_cmd_ptr;
-      uint8_t cmd = cmd_ptr[cmd_offset];
-
-      if (cmd < 0x79) {
-        __auto_type cel_ptrs_for_cur_level = NEAR_U16_PTR(RES_MAPPED + *cel_level_table_offset);
-        __auto_type cur_cel_data = (struct costume_cel*)(RES_MAPPED + cel_ptrs_for_cur_level[cmd]);
-        cel_data[level] = cur_cel_data;
-
-        // calculate scene x position in pixels for this actor cel image
-        int16_t cel_x    = pos_x;
-        int16_t dx_level = dx + cur_cel_data->offset_x;
-        if (mirror) {
-          cel_x -= dx_level + cur_cel_data->width - 16;
-        }
-        else {
-          cel_x += dx_level + 8;
-        }
-
-        // calculate scene y position in pixels for this actor cel image
-        int16_t dy_level = dy + cur_cel_data->offset_y;
-        int16_t cel_y    = pos_y + dy_level;
-        
-        // adjust bounding box for all cels
-        //debug_out("min_y %d, cel_y %d, max_y %d", min_y, cel_y, max_y);
-        min_x = min(min_x, cel_x);
-        min_y = min(min_y, cel_y);
-        max_x = max(max_x, cel_x + (int16_t)cur_cel_data->width);
-        max_y = max(max_y, cel_y + (int16_t)cur_cel_data->height);
-
-        // remember position for this cel level
-        level_pos_x[level] = cel_x;
-        level_pos_y[level] = cel_y;
-
-        // adjust actor global cel offsets (for offsetting subsequent cels)
-        dx += cur_cel_data->move_x;
-        dy -= cur_cel_data->move_y;
-      }
-
-    }
-    ++cel_level_cmd_ptr;
-    ++cel_level_cur_cmd;
-    ++cel_level_table_offset;
-  }
-
-  uint8_t width  = max_x - min_x;
-  uint8_t height = max_y - min_y;
 
-  local_actors.bounding_box_x[local_id]      = min_x >> 3;
-  local_actors.bounding_box_y[local_id]      = min_y >> 1;
-  local_actors.bounding_box_width[local_id]  = (width + 7) >> 3;
-  local_actors.bounding_box_height[local_id] = (max_y - min_y + 1) >> 1;
+  int16_t min_x  = local_actors.canvas_x[local_id];
+  int16_t min_y  = local_actors.canvas_y[local_id];
+  uint8_t width  = local_actors.canvas_width[local_id];
+  uint8_t height = local_actors.canvas_height[local_id];
 
   // step 2: allocate an empty canvas for the actor 
   //debug_out("prepare min_x %d, min_y %d, width %d, height %d", min_x, min_y, width, height);
@@ -617,11 +560,17 @@ void actor_draw(uint8_t local_id)
   }
 
   // step 3: draw all cels to the allocated canvas
-  for (uint8_t level = 0; level < 16; ++level) {
-    if (cel_data[level] != NULL) {
-      uint8_t x = level_pos_x[level] - min_x;
-      uint8_t y = level_pos_y[level] - min_y;
-      gfx_draw_actor_cel(x, y, cel_data[level], mirror);
+  __auto_type cel_level_cel = local_actors.cel_level_cel[local_id];
+  __auto_type active_levels = local_actors.active_levels[local_id];
+  __auto_type cel_rel_x     = local_actors.cel_rel_x[local_id];
+  __auto_type cel_rel_y     = local_actors.cel_rel_y[local_id];
+  uint8_t num_active_levels = local_actors.num_active_levels[local_id];
+  for (uint8_t i = 0; i < num_active_levels; ++i) {
+    __auto_type cel = cel_level_cel[active_levels[i]];
+    if (cel != NULL) {
+      uint8_t x = pos_x + cel_rel_x[i] - min_x;
+      uint8_t y = pos_y + cel_rel_y[i] - min_y;
+      gfx_draw_actor_cel(x, y, cel, mirror);
     }
   }
 
@@ -719,20 +668,35 @@ static void deactivate_costume(uint8_t actor_id)
   }
 }
 
+/**
+  * @brief Starts walking to the next waypoint of the actor's route.
+  *
+  * The route is planned when a new walk was started, when all its waypoints are used up or
+  * when a walk box got locked or unlocked since planning. Otherwise, the next waypoint is
+  * just taken from the route. Waypoints that are already reached are skipped.
+  *
+  * @param local_id The local id of the actor.
+  */
 static void start_walking(uint8_t local_id)
 {
-  uint8_t actor_id    = local_actors.global_id[local_id];
-  uint8_t walk_to_box = local_actors.walk_to_box[local_id];
+  uint8_t actor_id = local_actors.global_id[local_id];
+
+  if ((local_actors.walking[local_id] & WALKING_STATE_RESTART) ||
+      local_actors.route_lock_gen[local_id] != walk_box_lock_gen) {
+    plan_route(local_id);
+  }
 
   for (;;) {
-    if (local_actors.cur_box[local_id] == walk_to_box) {
-      local_actors.next_x[local_id]   = local_actors.walk_to_x[local_id];
-      local_actors.next_y[local_id]   = local_actors.walk_to_y[local_id];
-      local_actors.next_box[local_id] = walk_to_box;
-      break;
+    if (local_actors.route_pos[local_id] >= local_actors.route_len[local_id]) {
+      plan_route(local_id);
     }
-    calculate_next_box_point(local_id);
-    if (!is_next_walk_to_point_reached(actor_id, local_id)) {
+    uint8_t pos = local_actors.route_pos[local_id]++;
+    local_actors.next_box[local_id] = local_actors.route_box[local_id][pos];
+    local_actors.next_x[local_id]   = local_actors.route_x[local_id][pos];
+    local_actors.next_y[local_id]   = local_actors.route_y[local_id][pos];
+    // the final waypoint is the only one not leading into another box
+    if (local_actors.next_box[local_id] == local_actors.cur_box[local_id] ||
+        !is_next_walk_to_point_reached(actor_id, local_id)) {
       break;
     }
     local_actors.cur_box[local_id] = local_actors.next_box[local_id];
@@ -828,6 +792,7 @@ static void stop_walking(uint8_t local_id)
     local_actors.walk_to_x[local_id]   = actors.x[actor_id];
     local_actors.walk_to_y[local_id]   = actors.y[actor_id];
     local_actors.masking[local_id]     = walkbox_get_box_masking(cur_box);
+    local_actors.route_len[local_id]   = 0;
     return;
   }
 
@@ -847,60 +812,90 @@ static void stop_walking(uint8_t local_id)
     
     if (!turn_to_target_direction(local_id)) {
       local_actors.walking[local_id] = WALKING_STATE_STOPPING;
+      return;
     }
-    else {
-      local_actors.walking[local_id] = WALKING_STATE_FINISHED;
-    }
+    local_actors.walking[local_id] = WALKING_STATE_FINISHED;
   }
   else {
     //debug_out(" stopping");
     local_actors.walking[local_id] = WALKING_STATE_FINISHED;
   }
+  vm_signal_event(actor_id);
 }
 
-static void calculate_next_box_point(uint8_t local_id)
+/**
+  * @brief Plans the complete route of a walking actor.
+  *
+  * Starting at the actor's current box and position, the box sequence to the walk-to box is
+  * followed and for each box transition, the waypoint in the current box closest to the next
+  * box is stored in the actor's route. The last waypoint is the walk-to position itself. The
+  * waypoints are the same the actor would reach when calculating them at each box transition,
+  * as the actor always stops exactly at the previous waypoint.
+  *
+  * There are boxes you can't reach (either locked or no transition to them). In that case, the
+  * route ends at the point closest to the target in the last reachable box, and the walk-to
+  * position is changed accordingly. Routes longer than MAX_ROUTE_LEN are continued by planning
+  * again once the last stored waypoint is reached.
+  *
+  * @param local_id The local id of the actor.
+  */
+static void plan_route(uint8_t local_id)
 {
-  // no auto-restore as this functions gets inlined
-  SAVE_DS
+  SAVE_DS_AUTO_RESTORE
   // need to map in room data for walkbox access
   map_ds_resource(room_res_slot);
 
+  uint8_t actor_id   = local_actors.global_id[local_id];
   uint8_t cur_box    = local_actors.cur_box[local_id];
   uint8_t target_box = local_actors.walk_to_box[local_id];
-  uint8_t next_box   = walkbox_get_next_box(cur_box, target_box);
-  
-  // There are boxes you can't reach (either locked or no transition to them).
-  // In case of no transition, we will be told to stay in the current box.
-  // Go to the closest point to the target that we can find in the current box.
-  if (next_box == cur_box || walk_boxes[next_box].classes & WALKBOX_CLASS_BOX_LOCKED) {
-    uint8_t target_x = local_actors.walk_to_x[local_id];
-    uint8_t target_y = local_actors.walk_to_y[local_id];
-
-    walkbox_find_closest_box_point(cur_box, &target_x, &target_y);
-    
-    local_actors.walk_to_x[local_id] = target_x;
-    local_actors.next_x[local_id]    = target_x;
-    local_actors.walk_to_y[local_id] = target_y;
-    local_actors.next_y[local_id]    = target_y;
-    local_actors.next_box[local_id]  = cur_box;
+  uint8_t x          = actors.x[actor_id];
+  uint8_t y          = actors.y[actor_id];
+  uint8_t len        = 0;
+
+  __auto_type route_box = local_actors.route_box[local_id];
+  __auto_type route_x   = local_actors.route_x[local_id];
+  __auto_type route_y   = local_actors.route_y[local_id];
+
+  do {
+    if (cur_box == target_box) {
+      route_box[len] = cur_box;
+      route_x[len]   = local_actors.walk_to_x[local_id];
+      route_y[len]   = local_actors.walk_to_y[local_id];
+      ++len;
+      break;
+    }
 
-    RESTORE_DS
-    return;
-  }
+    uint8_t next_box = walkbox_get_next_box(cur_box, target_box);
+    if (next_box == cur_box || walk_boxes[next_box].classes & WALKBOX_CLASS_BOX_LOCKED) {
+      // go to the closest point to the target that we can find in the current box
+      uint8_t target_x = local_actors.walk_to_x[local_id];
+      uint8_t target_y = local_actors.walk_to_y[local_id];
+      walkbox_find_closest_box_point(cur_box, &target_x, &target_y);
+      local_actors.walk_to_x[local_id] = target_x;
+      local_actors.walk_to_y[local_id] = target_y;
+
+      route_box[len] = cur_box;
+      route_x[len]   = target_x;
+      route_y[len]   = target_y;
+      ++len;
+      break;
+    }
 
-  uint8_t actor_id   = local_actors.global_id[local_id];
-  uint8_t next_box_x = actors.x[actor_id];
-  uint8_t next_box_y = actors.y[actor_id];
-
-  //debug_out("Cur %d Next %d Target %d", cur_box, next_box, target_box);
-  walkbox_find_closest_box_point(next_box, &next_box_x, &next_box_y);
-  walkbox_find_closest_box_point(cur_box, &next_box_x, &next_box_y);
-  //debug_out("Next box point %d, %d", next_box_x, next_box_y);
-  local_actors.next_x[local_id]   = next_box_x;
-  local_actors.next_y[local_id]   = next_box_y;
-  local_actors.next_box[local_id] = next_box;
-
-  RESTORE_DS
+    //debug_out("Cur %d Next %d Target %d", cur_box, next_box, target_box);
+    walkbox_find_closest_box_point(next_box, &x, &y);
+    walkbox_find_closest_box_point(cur_box, &x, &y);
+    //debug_out("Next box point %d, %d", x, y);
+    route_box[len] = next_box;
+    route_x[len]   = x;
+    route_y[len]   = y;
+    ++len;
+    cur_box = next_box;
+  }
+  while (len != MAX_ROUTE_LEN);
+
+  local_actors.route_len[local_id]      = len;
+  local_actors.route_pos[local_id]      = 0;
+  local_actors.route_lock_gen[local_id] = walk_box_lock_gen;
 }
 
 /**
@@ -956,6 +951,13 @@ static void add_local_actor(uint8_t actor_id)
   actors.local_id[actor_id]        = local_id;
   local_actors.global_id[local_id] = actor_id;
 
+  // append to draw order, actor_place_at will move it to its sorted position
+  uint8_t i = 0;
+  while (local_actors.draw_order[i] != 0xff) {
+    ++i;
+  }
+  local_actors.draw_order[i] = local_id;
+
   activate_costume(actor_id);
   
   actor_place_at(actor_id, actors.x[actor_id], actors.y[actor_id]);
@@ -965,15 +967,70 @@ static void add_local_actor(uint8_t actor_id)
 
 static void remove_local_actor(uint8_t actor_id)
 {
+  uint8_t local_id = actors.local_id[actor_id];
+
+  // remove from draw order
+  uint8_t i = 0;
+  while (i < MAX_LOCAL_ACTORS && local_actors.draw_order[i] != local_id) {
+    ++i;
+  }
+  if (i < MAX_LOCAL_ACTORS) {
+    for (; i < MAX_LOCAL_ACTORS - 1; ++i) {
+      local_actors.draw_order[i] = local_actors.draw_order[i + 1];
+    }
+    local_actors.draw_order[MAX_LOCAL_ACTORS - 1] = 0xff;
+  }
+
   deactivate_costume(actor_id);
-  local_actors.global_id[actors.local_id[actor_id]] = 0xff;
+  local_actors.global_id[local_id] = 0xff;
   actors.local_id[actor_id] = 0xff;
+  // scripts waiting for the actor to stop walking can continue
+  vm_signal_event(actor_id);
   //debug_out("Actor %d is no longer in current room", actor_id);
 }
 
+/**
+  * @brief Moves an actor to its sorted position in the draw order.
+  *
+  * Actors are drawn sorted by their y position. Only the position of the actor with the given
+  * local id can have changed, so a single insertion step keeps the draw order sorted. Actors
+  * with equal y positions keep their previous order.
+  *
+  * @param local_id The local id of the actor that changed its position.
+  */
+static void update_draw_order(uint8_t local_id)
+{
+  __auto_type draw_order = local_actors.draw_order;
+  uint8_t y = actors.y[local_actors.global_id[local_id]];
+
+  uint8_t i = 0;
+  while (i < MAX_LOCAL_ACTORS && draw_order[i] != local_id) {
+    ++i;
+  }
+  if (i == MAX_LOCAL_ACTORS) {
+    return;
+  }
+
+  // move towards the front while the previous actor is further down
+  while (i != 0 && actors.y[local_actors.global_id[draw_order[i - 1]]] > y) {
+    draw_order[i] = draw_order[i - 1];
+    --i;
+  }
+  // move towards the back while the next actor is further up
+  while (i != MAX_LOCAL_ACTORS - 1 && draw_order[i + 1] != 0xff &&
+         actors.y[local_actors.global_id[draw_order[i + 1]]] < y) {
+    draw_order[i] = draw_order[i + 1];
+    ++i;
+  }
+  draw_order[i] = local_id;
+}
+
 static void reset_animation(uint8_t local_id)
 {
   uint8_t global_id = local_actors.global_id[local_id];
+
+  local_actors.num_active_levels[local_id] = 0;
+  local_actors.cel_layout_mirror[local_id] = 0xff;
   
   if (!actors.costume[global_id]) {
     return;
@@ -992,6 +1049,150 @@ static void reset_animation(uint8_t local_id)
   actor_start_animation(local_id, ANIM_MOUTH_SHUT + dir);
 }
 
+/**
+  * @brief Resolves the cel for the current animation command of a cel level.
+  *
+  * The resolved cel pointer is cached, so drawing an actor does not need to look up the
+  * command and the cel tables of each level again. Commands of 0x79 and above don't show a cel.
+  *
+  * Needs the costume resource of the actor mapped to DS.
+  *
+  * @param local_id The local id of the actor.
+  * @param level The cel level to resolve.
+  */
+static void resolve_level_cel(uint8_t local_id, uint8_t level)
+{
+  uint8_t cmd_offset = local_actors.cel_level_cur_cmd[local_id][level];
+  uint8_t cmd        = local_actors.cel_level_cmd_ptr[local_id][level][cmd_offset];
+  struct costume_cel *cel = NULL;
+
+  if (cmd < 0x79) {
+    __auto_type hdr                    = (struct costume_header *)RES_MAPPED;
+    __auto_type cel_ptrs_for_cur_level = NEAR_U16_PTR(RES_MAPPED + hdr->level_table_offsets[level]);
+    cel = (struct costume_cel *)(RES_MAPPED + cel_ptrs_for_cur_level[cmd]);
+  }
+
+  local_actors.cel_level_cel[local_id][level] = cel;
+  local_actors.cel_layout_mirror[local_id]     = 0xff;
+}
+
+/**
+  * @brief Calculates the cel positions and bounding box of an actor relative to its position.
+  *
+  * The layout only depends on the current cels and the mirror state, so it is calculated once
+  * after the cels changed and reused for all redraws of the actor until then.
+  *
+  * Needs the costume resource of the actor mapped to DS.
+  *
+  * @param local_id The local id of the actor.
+  * @param mirror Whether the actor is drawn mirrored (facing left).
+  */
+static void calculate_cel_layout(uint8_t local_id, uint8_t mirror)
+{
+  __auto_type cel_level_cel = local_actors.cel_level_cel[local_id];
+  __auto_type active_levels = local_actors.active_levels[local_id];
+  __auto_type cel_rel_x     = local_actors.cel_rel_x[local_id];
+  __auto_type cel_rel_y     = local_actors.cel_rel_y[local_id];
+  uint8_t num_active_levels = local_actors.num_active_levels[local_id];
+
+  int16_t min_x = 0x7fff;
+  int16_t min_y = 0x7fff;
+  int16_t max_x = -0x8000;
+  int16_t max_y = -0x8000;
+  int16_t dx    = -72;
+  int16_t dy    = -100;
+
+  for (uint8_t i = 0; i < num_active_levels; ++i) {
+    __auto_type cur_cel_data = cel_level_cel[active_levels[i]];
+    if (!cur_cel_data) {
+      continue;
+    }
+
+    // x position in pixels relative to the actor position
+    int16_t dx_level = dx + cur_cel_data->offset_x;
+    int16_t cel_x;
+    if (mirror) {
+      cel_x = -(dx_level + (int16_t)cur_cel_data->width - 16);
+    }
+    else {
+      cel_x = dx_level + 8;
+    }
+
+    // y position in pixels relative to the actor position
+    int16_t cel_y = dy + cur_cel_data->offset_y;
+
+    // adjust bounding box for all cels
+    min_x = min(min_x, cel_x);
+    min_y = min(min_y, cel_y);
+    max_x = max(max_x, cel_x + (int16_t)cur_cel_data->width);
+    max_y = max(max_y, cel_y + (int16_t)cur_cel_data->height);
+
+    cel_rel_x[i] = cel_x;
+    cel_rel_y[i] = cel_y;
+
+    // adjust actor global cel offsets (for offsetting subsequent cels)
+    dx += cur_cel_data->move_x;
+    dy -= cur_cel_data->move_y;
+  }
+
+  local_actors.cels_min_x[local_id]        = min_x;
+  local_actors.cels_min_y[local_id]        = min_y;
+  local_actors.cels_max_x[local_id]        = max_x;
+  local_actors.cels_max_y[local_id]        = max_y;
+  local_actors.cel_layout_mirror[local_id] = mirror;
+}
+
+/**
+  * @brief Calculates the canvas and bounding box of an actor for drawing its current cels.
+  *
+  * The cel layout is recalculated if it is outdated or the actor changed its mirroring.
+  *
+  * @param local_id The local id of the actor.
+  */
+static void calculate_canvas(uint8_t local_id)
+{
+  uint8_t global_id = local_actors.global_id[local_id];
+
+  uint16_t pos_x = actors.x[global_id];
+  pos_x <<= 3; // convert to pixel position
+
+  uint8_t pos_y = actors.y[global_id] - actors.elevation[global_id];
+  pos_y <<= 1; // convert to pixel position
+
+  map_ds_resource(local_actors.res_slot[local_id]);
+  __auto_type hdr = (struct costume_header *)RES_MAPPED;
+
+  // the relative cel positions only change with the cels
+  uint8_t mirror = actors.dir[global_id] == 0 && !(hdr->disable_mirroring_and_format & 0x80);
+  if (local_actors.cel_layout_mirror[local_id] != mirror) {
+    calculate_cel_layout(local_id, mirror);
+  }
+
+  int16_t min_x = 0x7fff;
+  int16_t min_y = 0xff;
+  int16_t max_x = 0;
+  int16_t max_y = 0;
+  if (local_actors.cels_min_x[local_id] <= local_actors.cels_max_x[local_id]) {
+    min_x = (int16_t)pos_x + local_actors.cels_min_x[local_id];
+    min_y = min(min_y, (int16_t)pos_y + local_actors.cels_min_y[local_id]);
+    max_x = max(max_x, (int16_t)pos_x + local_actors.cels_max_x[local_id]);
+    max_y = max(max_y, (int16_t)pos_y + local_actors.cels_max_y[local_id]);
+  }
+
+  uint8_t width  = max_x - min_x;
+  uint8_t height = max_y - min_y;
+
+  local_actors.canvas_x[local_id]      = min_x;
+  local_actors.canvas_y[local_id]      = min_y;
+  local_actors.canvas_width[local_id]  = width;
+  local_actors.canvas_height[local_id] = height;
+
+  local_actors.bounding_box_x[local_id]      = min_x >> 3;
+  local_actors.bounding_box_y[local_id]      = min_y >> 1;
+  local_actors.bounding_box_width[local_id]  = (width + 7) >> 3;
+  local_actors.bounding_box_height[local_id] = (max_y - min_y + 1) >> 1;
+}
+
 /**
   * @brief Update the walk direction of the actor.
   *
@@ -19,12 +19,14 @@
 
 #pragma once
 
+#include "costume.h"
 #include "vm.h"
 #include <stdint.h>
 
 #define NUM_ACTORS         25
 #define MAX_LOCAL_ACTORS    6
 #define ACTOR_NAME_LEN     16
+#define MAX_ROUTE_LEN       8
 
 typedef struct {
   uint8_t       sound[NUM_ACTORS];
@@ -48,10 +50,24 @@ typedef struct {
   uint8_t       bounding_box_y[MAX_LOCAL_ACTORS];
   uint8_t       bounding_box_width[MAX_LOCAL_ACTORS];
   uint8_t       bounding_box_height[MAX_LOCAL_ACTORS];
+  int16_t       canvas_x[MAX_LOCAL_ACTORS];          // canvas in pixels, calculated for all actors
+  int16_t       canvas_y[MAX_LOCAL_ACTORS];          // before the first one is drawn
+  uint8_t       canvas_width[MAX_LOCAL_ACTORS];
+  uint8_t       canvas_height[MAX_LOCAL_ACTORS];
   uint8_t       cel_anim[MAX_LOCAL_ACTORS][16];
   uint8_t      *cel_level_cmd_ptr[MAX_LOCAL_ACTORS][16];
   uint8_t       cel_level_cur_cmd[MAX_LOCAL_ACTORS][16];
   uint8_t       cel_level_last_cmd[MAX_LOCAL_ACTORS][16];
+  struct costume_cel *cel_level_cel[MAX_LOCAL_ACTORS][16];  // cel of current cmd, NULL if none
+  uint8_t       active_levels[MAX_LOCAL_ACTORS][16];         // ascending list of running levels
+  uint8_t       num_active_levels[MAX_LOCAL_ACTORS];
+  int16_t       cel_rel_x[MAX_LOCAL_ACTORS][16];     // cel positions relative to the actor position,
+  int16_t       cel_rel_y[MAX_LOCAL_ACTORS][16];     // indexed like active_levels
+  int16_t       cels_min_x[MAX_LOCAL_ACTORS];        // bounding box of all cels relative to the
+  int16_t       cels_min_y[MAX_LOCAL_ACTORS];        // actor position
+  int16_t       cels_max_x[MAX_LOCAL_ACTORS];
+  int16_t       cels_max_y[MAX_LOCAL_ACTORS];
+  uint8_t       cel_layout_mirror[MAX_LOCAL_ACTORS]; // mirror state of the layout, 0xff if outdated
   uint8_t       walking[MAX_LOCAL_ACTORS];
   uint8_t       x_accum[MAX_LOCAL_ACTORS];
   uint8_t       y_accum[MAX_LOCAL_ACTORS];
@@ -69,7 +85,14 @@ typedef struct {
   uint8_t       next_box[MAX_LOCAL_ACTORS];
   uint8_t       next_x[MAX_LOCAL_ACTORS];
   uint8_t       next_y[MAX_LOCAL_ACTORS];
+  uint8_t       route_box[MAX_LOCAL_ACTORS][MAX_ROUTE_LEN];
+  uint8_t       route_x[MAX_LOCAL_ACTORS][MAX_ROUTE_LEN];
+  uint8_t       route_y[MAX_LOCAL_ACTORS][MAX_ROUTE_LEN];
+  uint8_t       route_len[MAX_LOCAL_ACTORS];
+  uint8_t       route_pos[MAX_LOCAL_ACTORS];
+  uint8_t       route_lock_gen[MAX_LOCAL_ACTORS];
   uint8_t       masking[MAX_LOCAL_ACTORS];
+  uint8_t       draw_order[MAX_LOCAL_ACTORS];  // local ids sorted by y, unused entries are 0xff
 } local_actors_t;
 
 //-----------------------------------------------------------------------------------------------
@@ -65,4 +65,7 @@ typedef enum {
     ERR_INDEX_LOAD_FAILED = 43,
     ERR_REALHW_ONLY = 44,
     ERR_LANG_NOT_SUPPORTED = 45,
+    ERR_REPLAY_BUFFER_FULL = 46,
+    ERR_REPLAY_FILE_INVALID = 47,
+    ERR_OUT_OF_CHAR_MEMORY = 48,
 } error_code_t;
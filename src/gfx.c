@@ -37,11 +37,15 @@
 
 #define GFX_HEIGHT 128
 #define CHRCOUNT 120
+#define RRB_ROW_LIMIT (CHRCOUNT - 3) // max chars per row, leaving room for the final gotox to the right edge
+#define NUM_BG_CHARS 42 // gotox + 41 bg columns (the last one is needed when scrolled by sub-char offsets)
 #define SCREEN_RAM_SENTENCE (SCREEN_RAM + CHRCOUNT * 2 * 18)
 #define SCREEN_RAM_VERBS (SCREEN_RAM + CHRCOUNT * 2 * 19)
 #define SCREEN_RAM_INVENTORY (SCREEN_RAM + CHRCOUNT * 2 * 22)
 #define UNBANKED_PTR(ptr) ((void __far *)((uint32_t)(ptr) - 0x2000UL + GFX_SECTION))
 #define UNBANKED_SPR_PTR(ptr) ((void *)(((uint32_t)(ptr)  - 0x2000UL + GFX_SECTION) / 64))
+#define OBJ_IMAGE_PENDING 0x8000 // obj_first_char flag: image is reserved but not yet decoded
+#define MIN_ACTOR_ARENA_SIZE 0x800 // each actor arena needs to hold at least one big actor canvas
 #define UNBANKED_SCR_PTR(ptr) ((void *)(((uint32_t)(ptr)  - 0x2000UL + SCREEN_RAM) / 64))
 
 //-----------------------------------------------------------------------------------------------
@@ -142,8 +146,13 @@ __attribute__((aligned(64))) static uint8_t blank_sprite[53];
 
 __attribute__((aligned(16))) static uint8_t *sprite_pointers[8];
 static uint8_t color_strip[GFX_HEIGHT];
+static uint8_t mask_char[64];
 static uint8_t __huge *next_char_data;
 static uint8_t __huge *char_data_start_actors;
+static uint8_t __huge *next_actor_char_data;
+static uint32_t actor_arena_end;
+static uint32_t actor_arena_size;
+static uint8_t actor_arena;
 static uint16_t obj_first_char[MAX_OBJECTS];
 static uint8_t obj_x[MAX_OBJECTS];
 static uint8_t obj_y[MAX_OBJECTS];
@@ -156,6 +165,9 @@ static uint8_t next_obj_slot = 0;
 static uint8_t flashlight_irq_update;
 static uint8_t bg_chars_per_row;
 static uint8_t num_chars_at_row[16];
+static uint8_t rrb_row_reserved[16];
+static uint16_t rrb_row_next_gotox_scr[16];
+static uint16_t rrb_row_last_gotox_col[16];
 static uint8_t masking_cache_iterations[119];
 static uint16_t masking_cache_data_offset[119];
 static uint8_t num_masking_cache_cols = 0;
@@ -163,11 +175,15 @@ static uint8_t masking_column[GFX_HEIGHT];
 static uint16_t masking_data_room_offset;
 static uint32_t masking_char_data;
 static uint16_t screen_pixel_offset_x;
+static uint16_t bg_left_char;
+static uint8_t obj_clip_x1;
+static uint8_t obj_clip_x2;
 static int16_t actor_x;
 static int8_t actor_y;
 static uint8_t actor_width;
 static uint8_t actor_height;
-static uint8_t actor_palette;
+static uint8_t actor_palette = 0xff;
+static uint8_t actor_color_map[16]; // cel color nibble to palette index of actor_palette
 static uint32_t actor_char_data;
 
 static dmalist_single_option_t dmalist_copy_gfx[2];
@@ -175,7 +191,9 @@ static dmalist_single_option_t dmalist_copy_gfx_dark[3];
 static dmalist_t dmalist_clear_dialog_screen;
 static dmalist_t dmalist_clear_actor_chars;
 static dmalist_three_options_no_3rd_arg_t dmalist_rle_strip_copy;
+static dmalist_two_options_no_2nd_arg_t dmalist_mask_char_copy;
 static dmalist_t dmalist_reset_rrb;
+static dmalist_t dmalist_scroll_row;
 static dmalist_t dmalist_clear_sentence;
 static dmalist_t dmalist_clear_verbs;
 static dmalist_t dmalist_clear_inventory;
@@ -196,8 +214,12 @@ static uint8_t __huge *decode_rle_bitmap(uint8_t __huge *src, uint16_t width, ui
 static void reset_objects(void);
 static void update_cursor(uint8_t snail_override);
 static void set_dialog_color(uint8_t color);
-static uint16_t check_next_char_data_wrap_around(uint8_t width, uint8_t height);
-static void place_rrb_object(uint16_t char_num, int16_t screen_pos_x, int8_t screen_pos_y, uint8_t width_chars, uint8_t height_chars);
+static void decode_object_image(uint8_t local_id);
+static void set_actor_char_data_start(void);
+static int8_t rrb_first_row(int8_t screen_pos_y);
+static void reserve_rrb_rows(int8_t screen_pos_y, uint8_t height_chars, int8_t num_chars);
+static uint16_t rrb_gotox_col(int8_t y, int8_t last_but_one_row, uint8_t shift_y);
+static uint8_t place_rrb_object(uint16_t char_num, int16_t screen_pos_x, int8_t screen_pos_y, uint8_t width_chars, uint8_t height_chars);
 static void apply_actor_masking(void);
 static void decode_single_mask_column(int16_t col, int8_t y_start, uint8_t num_lines);
 static void decode_object_mask_column(uint8_t local_id, int16_t col, uint8_t y_start, uint8_t num_lines, uint8_t idx_dst);
@@ -258,7 +280,8 @@ void gfx_init()
     *colram_bb_ptr++ = 0xff00;
   }
 
-  bg_chars_per_row = 41;
+  bg_chars_per_row = NUM_BG_CHARS;
+  obj_clip_x2 = NUM_BG_CHARS - 2;
   for (uint8_t i = 0; i < 16; ++i) {
     num_chars_at_row[i] = bg_chars_per_row;
   }
@@ -466,9 +489,31 @@ static void init_dma_lists(void)
     .dst_bank       = 0x00
   };
 
+  dmalist_mask_char_copy = (dmalist_two_options_no_2nd_arg_t) {
+    .opt_token1     = 0x86,                   // transparent color handling
+    .opt_arg1       = 0x01,                   // transparent color (= keep actor pixel)
+    .opt_token2     = 0x07,                   // enable transparent color handling
+    .end_of_options = 0x00,
+    .command        = DMA_CMD_COPY,
+    .count          = 64,
+    .src_addr       = LSB16(UNBANKED_PTR(mask_char)),
+    .src_bank       = BANK(UNBANKED_PTR(mask_char)),
+    .dst_addr       = 0x0000,
+    .dst_bank       = 0x00
+  };
+
   dmalist_reset_rrb = (dmalist_t) {
     .command        = DMA_CMD_FILL,
-    .count          = (CHRCOUNT - 41) * 2,
+    .count          = (CHRCOUNT - NUM_BG_CHARS) * 2,
+    .src_addr       = 0x0000,
+    .src_bank       = 0x00,
+    .dst_addr       = 0x0000,
+    .dst_bank       = 0x00
+  };
+
+  dmalist_scroll_row = (dmalist_t) {
+    .command        = DMA_CMD_COPY,
+    .count          = (NUM_BG_CHARS - 2) * 2,
     .src_addr       = 0x0000,
     .src_bank       = 0x00,
     .dst_addr       = 0x0000,
@@ -674,7 +719,7 @@ void gfx_update_flashlight(void)
   //__auto_type bg_scr_ptr = NEAR_U16_PTR(0x2000) + CHRCOUNT * 2 + 1;
   __auto_type bg_scr_ptr = &(screenram.rows[2].chars[1]);
   // map color ram to 0x8000
-  __auto_type bg_col_ptr = FAR_U16_PTR(COLRAM) + CHRCOUNT * 2 + 41;
+  __auto_type bg_col_ptr = FAR_U16_PTR(COLRAM) + CHRCOUNT * 2 + NUM_BG_CHARS;
 
   uint8_t fl_width   = vm_state.flashlight_width;
   uint8_t pos_x_char = (INPUT_CURSOR_X2 / 4) - (fl_width / 2);
@@ -713,12 +758,13 @@ void gfx_update_flashlight(void)
 
   ++fl_rows_left;
 
-  uint16_t gotox_scr     = pos_x_char << 3;
+  // bg chars are shifted left by the camera's sub-char offset
+  uint16_t gotox_scr     = ((pos_x_char << 3) - camera_fine_x) & 0x3ff;
   uint16_t fl_corner_col = 0x1100; // color 0x61 is 2nd col in alternate palette and is always black
   for (uint8_t y = 0; y < 16; ++y) {
     uint16_t col_val;
     uint16_t scr_val;
-    uint8_t  scr_idx_corner_left  = 41 + fl_width;
+    uint8_t  scr_idx_corner_left  = NUM_BG_CHARS + fl_width;
     uint8_t  scr_idx_corner_right = scr_idx_corner_left + 2;
     uint16_t corner_char = 0;
     uint8_t  corner_rowmask;
@@ -735,7 +781,7 @@ void gfx_update_flashlight(void)
 
       // copy background chars to flashlight rrb area
       uint16_t *bg_scr = bg_scr_ptr + pos_x_char;
-      uint16_t *fl_scr = bg_scr_ptr + 41;
+      uint16_t *fl_scr = bg_scr_ptr + NUM_BG_CHARS;
 
       for (uint8_t x = 0; x < fl_width; ++x) {
         *fl_scr = *bg_scr;
@@ -794,7 +840,7 @@ void gfx_update_flashlight(void)
       ++fl_col;
 
       // right corner
-      uint16_t x_position = gotox_scr + fl_width * 8 - 8;
+      uint16_t x_position = (gotox_scr + fl_width * 8 - 8) & 0x3ff;
       bg_scr_ptr[scr_idx_corner_right]     = make16(LSB(x_position), MSB(x_position) | y_offset);
       bg_scr_ptr[scr_idx_corner_right + 1] = corner_char + 1;
       *fl_col = make16(0x98, corner_rowmask);
@@ -805,7 +851,7 @@ void gfx_update_flashlight(void)
 
     *bg_col_ptr = col_val;
     bg_col_ptr += CHRCOUNT;
-    bg_scr_ptr[40] = scr_val;
+    bg_scr_ptr[NUM_BG_CHARS - 1] = scr_val;
     bg_scr_ptr += CHRCOUNT;
   }
 }
@@ -949,6 +995,7 @@ void gfx_clear_bg_image(void)
 
   // reset next_char_data pointer
   next_char_data = HUGE_U8_PTR(BG_BITMAP) + num_bytes;
+  set_actor_char_data_start();
 
   // reset object pointers
   reset_objects();
@@ -960,7 +1007,8 @@ void gfx_clear_bg_image(void)
   * The background bitmap is located at BG_BITMAP. The static pointer next_char_data
   * will point to the next byte following the last byte written to the background bitmap.
   * Object images will be stored as char data following the room background image
-  * (starting at next_char_data).
+  * (starting at next_char_data). The remaining char data memory is used for the actor
+  * canvases.
   * 
   * @param src The encoded bitmap data in the room resource.
   * @param width The width of the bitmap in characters.
@@ -976,7 +1024,7 @@ void gfx_decode_bg_image(uint8_t __huge *src, uint16_t width)
 
   decode_rle_bitmap(src, width, GFX_HEIGHT);
   
-  char_data_start_actors = next_char_data;
+  set_actor_char_data_start();
   
   reset_objects();
 }
@@ -1059,15 +1107,15 @@ void gfx_decode_masking_buffer(uint16_t bg_masking_offset, uint16_t width)
 }
 
 /**
-  * @brief Decodes an object image and stores it in the char data memory.
+  * @brief Reserves char data memory for an object image.
   *
-  * The static pointer next_char_data will point to the next byte following the last byte
-  * written to the char data memory. That way, object char data will be stored sequentially
-  * in memory. We will keep track of object IDs and their corresponding char numbers in
-  * the obj_first_char array.
+  * The static pointer next_char_data will point to the next byte following the reserved
+  * memory. That way, object char data will be stored sequentially in memory. We will keep
+  * track of object IDs and their corresponding char numbers in the obj_first_char array.
   *
-  * This function will map DS but won't restore it. It is assumed that the caller will
-  * restore the DS register after calling this function.
+  * The image itself is decoded when the object is drawn for the first time, so images of
+  * objects that never get visible won't cost any decoding time. The encoded image data
+  * needs to stay in place as long as the room is active.
   * 
   * @param src Pointer to the encoded object image data.
   * @param x X scene position of the object image in pixels.
@@ -1079,16 +1127,18 @@ void gfx_decode_masking_buffer(uint16_t bg_masking_offset, uint16_t width)
   */
 void gfx_set_object_image(uint8_t __huge *src, uint8_t x, uint8_t y, uint8_t width, uint8_t height)
 {
-  obj_first_char[next_obj_slot] = (uint32_t)next_char_data / 64;
+  obj_first_char[next_obj_slot] = ((uint32_t)next_char_data / 64) | OBJ_IMAGE_PENDING;
   obj_x[next_obj_slot]          = x;
   obj_y[next_obj_slot]          = y;
   obj_width[next_obj_slot]      = width;
   obj_height[next_obj_slot]     = height;
+  // until the image is decoded, we keep the pointer to the encoded image here
+  obj_mask_data[next_obj_slot]  = src;
 
-  obj_mask_data[next_obj_slot] = decode_rle_bitmap(src, width * 8, height * 8);
+  next_char_data += (uint16_t)width * height * 64;
 
   ++next_obj_slot;
-  char_data_start_actors = next_char_data;
+  set_actor_char_data_start();
 }
 
 /**
@@ -1140,7 +1190,9 @@ void gfx_print_dialog(uint8_t color, const char *text, uint8_t num_chars)
   * @brief Draws the current room's background image
   *
   * The background image is drawn to the backbuffer screen memory. The horizontal
-  * camera position is taken into account.
+  * camera position is taken into account. Sub-char camera offsets (camera_fine_x) are
+  * applied by the gotox character in the first column of each row, moving all background
+  * chars of the row to the left by that number of pixels.
   *
   * The room's background image is drawn with lights on if the lights parameter is non-zero.
   * If lights is zero, the room is drawn with lights off. The room's background image is
@@ -1158,32 +1210,126 @@ void gfx_draw_bg(uint8_t lights)
   UNMAP_DS
 
   uint16_t left_char_offset = camera_x - 20;
-  screen_pixel_offset_x = left_char_offset * 8;
+  screen_pixel_offset_x = left_char_offset * 8 + camera_fine_x;
+  bg_left_char = left_char_offset;
 
   __auto_type screen_ptr = NEAR_U16_PTR(BACKBUFFER_SCREEN) + CHRCOUNT * 2;
   __auto_type colram_ptr = NEAR_U16_PTR(BACKBUFFER_COLRAM) + CHRCOUNT * 2;
   uint16_t char_data = BG_BITMAP / 64 + left_char_offset * 16;
+  uint16_t gotox_scr = (-(int16_t)camera_fine_x) & 0x3ff;
 
-  for (uint8_t x = 0; x < 41; ++x) {
+  for (uint8_t x = 0; x < NUM_BG_CHARS; ++x) {
     for (uint8_t y = 0; y < 16; ++y) {
       if (x == 0) {
         // first char of each row is gotox character setting sprite/char priority
-        *screen_ptr = 0x0000;
+        *screen_ptr = gotox_scr;
         *colram_ptr = lights ? 0x0010 : 0x0050;
-        colram_ptr += CHRCOUNT;
       }
       else {
         *screen_ptr = char_data++;
+        if (x == NUM_BG_CHARS - 1) {
+          // last column might have been used by other rrb layers before
+          *colram_ptr = 0xff00;
+        }
       }
       screen_ptr += CHRCOUNT;
+      colram_ptr += CHRCOUNT;
     }
     screen_ptr -= CHRCOUNT * 16 - 1;
+    colram_ptr -= CHRCOUNT * 16 - 1;
   }
 
   memset(num_chars_at_row, bg_chars_per_row, 16);
   reset_objects();
 }
 
+/**
+  * @brief Scrolls the background in the backbuffer to the current camera position.
+  *
+  * If the camera moved by exactly one char column since the background was drawn, all
+  * background rows are shifted by one char using DMA (objects drawn into the background
+  * move along) and only the newly exposed column is written. Sub-char offsets are updated
+  * in the gotox character of each row. Bigger camera jumps will fall back to gfx_draw_bg.
+  *
+  * @param lights If non-zero, the room is drawn with lights on.
+  * @return Screen column (0-40) that needs objects to be drawn, 0xfe if only the sub-char
+  *         offset changed, or 0xff if the whole background was redrawn.
+  *
+  * Code section: code_gfx
+  */
+uint8_t gfx_scroll_bg(uint8_t lights)
+{
+  uint16_t left_char_offset = camera_x - 20;
+  int16_t  diff             = left_char_offset - bg_left_char;
+
+  if (diff > 1 || diff < -1) {
+    gfx_draw_bg(lights);
+    return 0xff;
+  }
+
+  SAVE_DS_AUTO_RESTORE
+  UNMAP_DS
+
+  screen_pixel_offset_x = left_char_offset * 8 + camera_fine_x;
+  bg_left_char = left_char_offset;
+
+  uint8_t  new_col  = 0xfe;
+  uint16_t row_addr = BACKBUFFER_SCREEN + CHRCOUNT * 4;
+  if (diff) {
+    if (diff > 0) {
+      // camera moved right: move chars 2..41 to 1..40
+      dmalist_scroll_row.src_bank = 0x00;
+      dmalist_scroll_row.dst_bank = 0x00;
+      row_addr += 2;
+      new_col = NUM_BG_CHARS - 2;
+    }
+    else {
+      // camera moved left: move chars 1..40 to 2..41, copying backwards (last byte first)
+      dmalist_scroll_row.src_bank = 0x40;
+      dmalist_scroll_row.dst_bank = 0x40;
+      row_addr += (NUM_BG_CHARS - 1) * 2 + 1;
+      new_col = 0;
+    }
+    for (uint8_t y = 0; y < 16; ++y) {
+      uint16_t src_addr = diff > 0 ? row_addr + 2 : row_addr - 2;
+      dmalist_scroll_row.src_addr = src_addr;
+      dmalist_scroll_row.dst_addr = row_addr;
+      dma_trigger(&dmalist_scroll_row);
+      row_addr += CHRCOUNT * 2;
+    }
+  }
+
+  __auto_type screen_ptr = NEAR_U16_PTR(BACKBUFFER_SCREEN) + CHRCOUNT * 2;
+  uint16_t char_data = BG_BITMAP / 64 + (left_char_offset + new_col) * 16;
+  uint16_t gotox_scr = (-(int16_t)camera_fine_x) & 0x3ff;
+  for (uint8_t y = 0; y < 16; ++y) {
+    screen_ptr[0] = gotox_scr;
+    if (new_col != 0xfe) {
+      screen_ptr[new_col + 1] = char_data++;
+    }
+    screen_ptr += CHRCOUNT;
+  }
+
+  return new_col;
+}
+
+/**
+  * @brief Restricts drawing of objects to the given screen columns.
+  *
+  * Used after scrolling to draw objects only into the newly exposed column without
+  * changing the z-order of objects that were already shifted along with the background.
+  *
+  * @param first_col First screen column (0-40) objects are drawn to.
+  * @param last_col Last screen column (0-40) objects are drawn to.
+  *
+  * Code section: code_gfx
+  */
+void gfx_set_object_clipping(uint8_t first_col, uint8_t last_col)
+{
+  obj_clip_x1 = first_col;
+  obj_clip_x2 = last_col;
+}
+
 /**
   * @brief Draws an object to the backbuffer.
   *
@@ -1205,6 +1351,10 @@ void gfx_draw_bg(uint8_t lights)
 void gfx_draw_object(uint8_t local_id, int8_t x, int8_t y)
 {
   //debug_out("Obj %d at %d, %d", local_id, x, y);
+  if (obj_first_char[local_id] & OBJ_IMAGE_PENDING) {
+    decode_object_image(local_id);
+  }
+
   uint16_t *screen_ptr;
   uint16_t char_num_col;
   uint16_t char_num_row   = obj_first_char[local_id];
@@ -1216,7 +1366,13 @@ void gfx_draw_object(uint8_t local_id, int8_t x, int8_t y)
   int8_t   col;
   uint8_t  first;
 
-  obj_draw_list[num_objects_drawn++] = local_id;
+  uint8_t i = 0;
+  while (i != num_objects_drawn && obj_draw_list[i] != local_id) {
+    ++i;
+  }
+  if (i == num_objects_drawn) {
+    obj_draw_list[num_objects_drawn++] = local_id;
+  }
 
   do {
     if (row >= 0 && row < 16) {
@@ -1226,7 +1382,7 @@ void gfx_draw_object(uint8_t local_id, int8_t x, int8_t y)
       char_num_col = char_num_row;
       first = 1;
       do {
-        if (col >= 0 && col < 40) {
+        if (col >= (int8_t)obj_clip_x1 && col <= (int8_t)obj_clip_x2) {
           if (first) {
             first = 0;
             screen_ptr += col;
@@ -1266,12 +1422,12 @@ void gfx_draw_object(uint8_t local_id, int8_t x, int8_t y)
 void gfx_enable_flashlight(void)
 {
   UNMAP_DS
-  __auto_type screen_ptr = NEAR_U16_PTR(BACKBUFFER_SCREEN) + CHRCOUNT * 2 + 41;
-  __auto_type colram_ptr = NEAR_U16_PTR(BACKBUFFER_COLRAM) + CHRCOUNT * 2 + 41;
+  __auto_type screen_ptr = NEAR_U16_PTR(BACKBUFFER_SCREEN) + CHRCOUNT * 2 + NUM_BG_CHARS;
+  __auto_type colram_ptr = NEAR_U16_PTR(BACKBUFFER_COLRAM) + CHRCOUNT * 2 + NUM_BG_CHARS;
 
   // 1x gotox for flashlight (+ flashlight_width for flashlight chars),
   // 2x gotox + 2x char for flashlight corners
-  bg_chars_per_row  = 41 + 5 + vm_state.flashlight_width;
+  bg_chars_per_row  = NUM_BG_CHARS + 5 + vm_state.flashlight_width;
 
   for (uint8_t i = 0; i < 16; ++i) {
     num_chars_at_row[i] = bg_chars_per_row;
@@ -1303,7 +1459,7 @@ void gfx_enable_flashlight(void)
 
 void gfx_disable_flashlight(void)
 {
-  bg_chars_per_row  = 41;
+  bg_chars_per_row  = NUM_BG_CHARS;
   flashlight_irq_update = 0;
 }
 
@@ -1312,6 +1468,27 @@ void gfx_flashlight_irq_update(uint8_t enable)
   flashlight_irq_update = enable;
 }
 
+/**
+  * @brief Reserves rrb chars for an actor canvas that will be drawn later this frame.
+  *
+  * Actors are drawn back to front, and each canvas placed later is shown on top. Reserving
+  * the chars of all canvases before drawing any of them makes place_rrb_object clip the
+  * canvases in the back when a row runs out of chars, so the front-most actors stay intact.
+  * The reservation is released by gfx_prepare_actor_drawing when the canvas gets placed.
+  *
+  * Code section: code_gfx
+  */
+void gfx_reserve_actor_canvas(int16_t pos_x, int8_t pos_y, uint8_t width, uint8_t height)
+{
+  int16_t screen_pos_x = pos_x - screen_pixel_offset_x;
+  if (screen_pos_x >= 320 || screen_pos_x + width < 0 || pos_y + height < 0) {
+    return;
+  }
+
+  // one gotox plus the canvas chars in each covered row
+  reserve_rrb_rows(pos_y, (height + 7) >> 3, ((width + 7) >> 3) + 1);
+}
+
 uint8_t gfx_prepare_actor_drawing(int16_t pos_x, int8_t pos_y, uint8_t width, uint8_t height, uint8_t palette)
 {
   int16_t screen_pos_x = pos_x - screen_pixel_offset_x;
@@ -1322,22 +1499,55 @@ uint8_t gfx_prepare_actor_drawing(int16_t pos_x, int8_t pos_y, uint8_t width, ui
   uint8_t actor_width_chars  = (width  + 7) >> 3;
   uint8_t actor_height_chars = (height + 7) >> 3;
 
+  // release the reservation made by gfx_reserve_actor_canvas, this canvas is placed now
+  reserve_rrb_rows(pos_y, actor_height_chars, -(int8_t)(actor_width_chars + 1));
+
   actor_x       = pos_x;
   actor_y       = pos_y;
   actor_width   = actor_width_chars  * 8;
   actor_height  = actor_height_chars * 8;
-  actor_palette = palette << 4;
 
-  uint16_t num_bytes = check_next_char_data_wrap_around(actor_width, actor_height);
-  actor_char_data  = (uint32_t)next_char_data;
-  next_char_data  += num_bytes;
+  if (palette != actor_palette) {
+    // color 0 stays transparent, all others are moved into the actor's palette
+    actor_palette = palette;
+    uint8_t color = palette << 4;
+    for (uint8_t i = 1; i < 16; ++i) {
+      actor_color_map[i] = ++color;
+    }
+  }
+
+  uint16_t num_bytes = actor_width * actor_height;
+  if ((uint32_t)next_actor_char_data + num_bytes > actor_arena_end) {
+    // The arena is full. Instead of dropping the actor, we continue in the other arena.
+    // Its canvases might still be shown until the next screen update, which is a glitch of at
+    // most one frame, like the wrap-around of the canvas memory used to be.
+    uint32_t other_arena = (uint32_t)char_data_start_actors + (actor_arena ? 0 : actor_arena_size);
+    uint32_t next        = (uint32_t)next_actor_char_data;
+    if (num_bytes <= actor_arena_size && (next < other_arena || next >= other_arena + actor_arena_size)) {
+      next_actor_char_data = HUGE_U8_PTR(other_arena);
+      actor_arena_end      = other_arena + actor_arena_size;
+    }
+    else {
+      // both arenas are used up, wrap around within all of the actor canvas memory
+      next_actor_char_data = char_data_start_actors;
+      actor_arena_end      = (uint32_t)char_data_start_actors + actor_arena_size * 2;
+      if (num_bytes > actor_arena_size * 2) {
+        fatal_error(ERR_CHRCOUNT_EXCEEDED);
+      }
+    }
+  }
+  actor_char_data = (uint32_t)next_actor_char_data;
+
+  if (!place_rrb_object(actor_char_data / 64, screen_pos_x, pos_y, actor_width_chars, actor_height_chars)) {
+    // no rrb chars left in the covered rows, skip the actor
+    return 0;
+  }
+  next_actor_char_data += num_bytes;
 
   dmalist_clear_actor_chars.count    = num_bytes;
   dmalist_clear_actor_chars.dst_addr = LSB16(actor_char_data);
   dmalist_clear_actor_chars.dst_bank = BANK(actor_char_data);
   dma_trigger(&dmalist_clear_actor_chars);
-
-  place_rrb_object(actor_char_data / 64, screen_pos_x, pos_y, actor_width_chars, actor_height_chars);
   
   return 1;
 }
@@ -1375,10 +1585,7 @@ void gfx_draw_actor_cel(uint8_t xpos, uint8_t ypos, struct costume_cel *cel_data
     {
       uint8_t data_byte = *rle_data++;
       run_length_counter = data_byte & 0x0f;
-      current_color = data_byte >> 4;
-      if (current_color) {
-        current_color |= actor_palette;
-      }
+      current_color = actor_color_map[data_byte >> 4];
       if (run_length_counter == 0)
       {
         run_length_counter = *rle_data++;
@@ -1403,42 +1610,88 @@ void gfx_draw_actor_cel(uint8_t xpos, uint8_t ypos, struct costume_cel *cel_data
   while (x != width);
 }
 
+/**
+  * @brief Applies background and object masking to the current actor canvas.
+  *
+  * The masking is applied per 8x8 char of the actor canvas. For each canvas char column, the
+  * (up to two) scene masking columns it covers are combined into color_strip, holding one mask
+  * byte per pixel row. Each 8x8 char is then handled with at most one DMA job:
+  * - no masked pixels: the char is skipped
+  * - all pixels masked: the char is cleared with a DMA fill
+  * - partially masked: an 8x8 mask char is built in mask_char (0x00 for masked pixels, 0x01 for
+  *   visible ones) and copied onto the actor char with transparent color 0x01, so only the
+  *   masked pixels are cleared.
+  *
+  * @param xpos Scene x position of the actor canvas in pixels.
+  * @param ypos Scene y position of the actor canvas in pixels.
+  * @param masking Masking flags of the actor's current walk box.
+  *
+  * Code section: code_gfx
+  */
 void gfx_apply_actor_masking(int16_t xpos, int8_t ypos, uint8_t masking)
 {
+  // Expands four mask bits (msb = leftmost pixel) into four pixel bytes of a mask char.
+  static const uint32_t mask_nibble_expand[16] = {
+    0x01010101, 0x00010101, 0x01000101, 0x00000101, 0x01010001, 0x00010001, 0x01000001, 0x00000001,
+    0x01010100, 0x00010100, 0x01000100, 0x00000100, 0x01010000, 0x00010000, 0x01000000, 0x00000000
+  };
+
   __auto_type cur_char_data = (uint32_t)actor_char_data;
 
-  uint8_t  cur_x    = 0;
-  uint8_t  cur_y    = 0;
-  uint8_t  mask     = 0x80;
-  uint16_t col_incr = (actor_height - 1) * 8;
+  uint8_t shift     = xpos & 7;
+  int16_t col       = i16_div_by_8(xpos);
+  uint8_t num_rows  = actor_height >> 3;
 
-  decode_single_mask_column(i16_div_by_8(xpos), ypos, actor_height);
-  mask >>= xpos & 7;
-  dmalist_rle_strip_copy.count = actor_height;
-  dmalist_rle_strip_copy.opt_token3 = 0x07; // enable transparent color handling
-  dmalist_rle_strip_copy.opt_arg2   = 0x01; // transparent color
+  decode_single_mask_column(col, ypos, actor_height);
 
-  do {
-    color_strip[cur_y] = (masking_column[cur_y] & mask) ? 0x00 : 0x01;
-    ++cur_y;
-    if (cur_y == actor_height) {
-      dmalist_rle_strip_copy.dst_addr = LSB16(cur_char_data);
-      dmalist_rle_strip_copy.dst_bank = BANK(cur_char_data);
-      dma_trigger(&dmalist_rle_strip_copy);
-      ++cur_char_data;
-      if ((((uint8_t)cur_char_data) & 0x07) == 0) {
-        cur_char_data += col_incr;
+  for (uint8_t cur_x = 0; cur_x != actor_width; cur_x += 8) {
+    // align scene masking columns to the canvas char column
+    for (uint8_t y = 0; y < actor_height; ++y) {
+      color_strip[y] = masking_column[y] << shift;
+    }
+    ++col;
+    if (shift || cur_x + 8 != actor_width) {
+      decode_single_mask_column(col, ypos, actor_height);
+    }
+    if (shift) {
+      uint8_t shift_right = 8 - shift;
+      for (uint8_t y = 0; y < actor_height; ++y) {
+        color_strip[y] |= masking_column[y] >> shift_right;
       }
-      ++cur_x;
-      cur_y = 0;
-      mask >>= 1;
-      if (!mask) {
-        decode_single_mask_column(i16_div_by_8(xpos + cur_x), ypos, actor_height);
-        mask = 0x80;
+    }
+
+    uint8_t *row_mask = color_strip;
+    for (uint8_t row = 0; row < num_rows; ++row) {
+      uint8_t mask_or  = 0x00;
+      uint8_t mask_and = 0xff;
+      for (uint8_t i = 0; i < 8; ++i) {
+        mask_or  |= row_mask[i];
+        mask_and &= row_mask[i];
+      }
+
+      if (mask_and == 0xff) {
+        // char fully hidden behind the background
+        dmalist_clear_actor_chars.count    = 64;
+        dmalist_clear_actor_chars.dst_addr = LSB16(cur_char_data);
+        dmalist_clear_actor_chars.dst_bank = BANK(cur_char_data);
+        dma_trigger(&dmalist_clear_actor_chars);
       }
+      else if (mask_or) {
+        __auto_type dst = (uint32_t *)mask_char;
+        for (uint8_t i = 0; i < 8; ++i) {
+          uint8_t m = row_mask[i];
+          *dst++ = mask_nibble_expand[m >> 4];
+          *dst++ = mask_nibble_expand[m & 0x0f];
+        }
+        dmalist_mask_char_copy.dst_addr = LSB16(cur_char_data);
+        dmalist_mask_char_copy.dst_bank = BANK(cur_char_data);
+        dma_trigger(&dmalist_mask_char_copy);
+      }
+
+      row_mask      += 8;
+      cur_char_data += 64;
     }
   }
-  while (cur_x != actor_width);
 }
 
 /**
@@ -1458,11 +1711,9 @@ void gfx_finalize_actor_drawing(void)
   __auto_type screen_start_ptr = NEAR_U16_PTR(BACKBUFFER_SCREEN) + CHRCOUNT * 2;
   __auto_type colram_start_ptr = NEAR_U16_PTR(BACKBUFFER_COLRAM) + CHRCOUNT * 2;
   for (uint8_t y = 0; y < 16; ++y) {
+    // place_rrb_object makes sure we never exceed RRB_ROW_LIMIT
     uint8_t end_of_row = num_chars_at_row[y];
     //max_end_of_row = max(max_end_of_row, end_of_row);
-    if (end_of_row >= CHRCOUNT - 2) {
-      fatal_error(ERR_CHRCOUNT_EXCEEDED);
-    }
     __auto_type screen_ptr = screen_start_ptr + end_of_row;
     __auto_type colram_ptr = colram_start_ptr + end_of_row;
     *screen_ptr++ = 0x0140; // gotox to right screen edge (x=320)
@@ -1484,12 +1735,25 @@ void gfx_finalize_actor_drawing(void)
   * Any new cels drawn will therefore overwrite any previously placed RRB objects.
   * We also zeroize the colram bytes beyond the 40 background picture chars each row.
   * This is to prevent accidental gotox back into the visual area.
+  * Actor canvases will be allocated from the other actor arena than last time.
   *
   * Code section: code_gfx
   */
 void gfx_reset_actor_drawing(void)
 {
+  // 0xffff will never match a gotox, so the first object in each row gets its own gotox
+  memset20(UNBANKED_PTR(rrb_row_next_gotox_scr), 0xff, sizeof(rrb_row_next_gotox_scr));
+
+  // switch to the other actor arena
+  actor_arena ^= 1;
+  next_actor_char_data = char_data_start_actors;
+  if (actor_arena) {
+    next_actor_char_data += actor_arena_size;
+  }
+  actor_arena_end = (uint32_t)next_actor_char_data + actor_arena_size;
+
   memset20(UNBANKED_PTR(num_chars_at_row), bg_chars_per_row, 16);
+  memset20(UNBANKED_PTR(rrb_row_reserved), 0, sizeof(rrb_row_reserved));
 
   // Next, zeroise all colram bytes beyond the 40 (+1 gotox) background picture chars each row.
   // This is to prevent the RRB to accidently do any gotox back into the visual area.
@@ -1727,24 +1991,67 @@ void set_dialog_color(uint8_t color)
   dma_trigger(&dmalist_clear_dialog_colram);
 }
 
-static uint16_t check_next_char_data_wrap_around(uint8_t width, uint8_t height)
+/**
+  * @brief Decodes a reserved object image into its char data memory.
+  *
+  * The pointer to the encoded image is replaced by the pointer to the object's masking
+  * data, which directly follows the image data.
+  *
+  * @param local_id The local object ID.
+  *
+  * Code section: code_gfx
+  */
+static void decode_object_image(uint8_t local_id)
 {
-  uint16_t num_bytes          = width * height;
-  uint32_t next_char_data_end = num_bytes + (uint32_t)next_char_data;
+  SAVE_DS_AUTO_RESTORE
 
-  if (next_char_data_end > MUSIC_DATA) { // end of gfx memory is where music data starts
-    next_char_data = char_data_start_actors;
-  }
-  return num_bytes;
+  uint16_t first_char = obj_first_char[local_id] & ~OBJ_IMAGE_PENDING;
+  obj_first_char[local_id] = first_char;
+
+  __auto_type next_char_data_save = next_char_data;
+  next_char_data = HUGE_U8_PTR((uint32_t)first_char * 64);
+  obj_mask_data[local_id] = decode_rle_bitmap(obj_mask_data[local_id], obj_width[local_id] * 8, obj_height[local_id] * 8);
+  next_char_data = next_char_data_save;
 }
 
-static void place_rrb_object(uint16_t char_num, int16_t screen_pos_x, int8_t screen_pos_y, uint8_t width_chars, uint8_t height_chars)
+/**
+  * @brief Splits the char data memory following the room image and objects into two actor arenas.
+  *
+  * Actor canvases are allocated from the two arenas in turns, one arena per actor redraw.
+  * This way, all canvases of the previous actor redraw stay intact while they might still
+  * be visible on screen, and all canvases of the redraw before get reclaimed at once.
+  * If a redraw doesn't fit into its arena, it continues in the other one, so actors are
+  * never dropped for lack of canvas memory.
+  *
+  * Called whenever char data for the room image or an object image gets reserved. Fails
+  * with ERR_OUT_OF_CHAR_MEMORY if the reservation leaves less than the minimum arena size
+  * for actors, so a room too big for char memory is caught on room load already.
+  *
+  * Code section: code_gfx
+  */
+static void set_actor_char_data_start(void)
 {
-  static uint8_t row_masks[8] = {0xff, 0x7f, 0x3f, 0x1f, 0x0f, 0x07, 0x03, 0x01};
-
-  //debug_out("place rrb object: char_num %d, x %d, y %d, width %d, height %d", char_num, screen_pos_x, screen_pos_y, width_chars, height_chars);
+  char_data_start_actors = next_char_data;
+  uint32_t start = (uint32_t)char_data_start_actors;
+  // end of gfx memory is where music data starts
+  if (start > MUSIC_DATA - 2 * MIN_ACTOR_ARENA_SIZE) {
+    fatal_error(ERR_OUT_OF_CHAR_MEMORY);
+  }
+  actor_arena_size = ((MUSIC_DATA - start) / 2) & ~0x3fUL;
+  actor_arena      = 0;
+  next_actor_char_data = char_data_start_actors;
+  actor_arena_end      = start;
+}
 
-  // place cel using rrb features
+/**
+  * @brief Returns the first backbuffer row covered by an rrb object, including its gotox row.
+  *
+  * The row can be negative if the object starts above the screen.
+  *
+  * Code section: code_gfx
+  */
+static int8_t rrb_first_row(int8_t screen_pos_y)
+{
   int8_t char_row;
   if (screen_pos_y < 0) {
     char_row = (int8_t)(screen_pos_y + 7) >> 3;  // This is the same as  char_row = screen_pos_y / 8;  for negative values
@@ -1752,6 +2059,75 @@ static void place_rrb_object(uint16_t char_num, int16_t screen_pos_x, int8_t scr
   }
   else {
     char_row = screen_pos_y >> 3;
+    if (!(screen_pos_y & 0x07)) {
+      --char_row;
+    }
+  }
+  return char_row;
+}
+
+/**
+  * @brief Adds num_chars (or removes them, if negative) to the reserved chars of all rows
+  * an rrb object at screen_pos_y covers.
+  *
+  * Code section: code_gfx
+  */
+static void reserve_rrb_rows(int8_t screen_pos_y, uint8_t height_chars, int8_t num_chars)
+{
+  int8_t row = rrb_first_row(screen_pos_y);
+  for (int8_t y = -1; y < (int8_t)height_chars; ++y) {
+    if (row >= 0 && row < 16) {
+      rrb_row_reserved[row] += num_chars;
+    }
+    ++row;
+  }
+}
+
+/**
+  * @brief Returns the colram word of the gotox char of row y of an rrb object.
+  *
+  * Row -1 is the partly covered row above the object, row last_but_one_row + 1 the partly
+  * covered row at its bottom. Both mask out the pixel lines not belonging to the object.
+  *
+  * Code section: code_gfx
+  */
+static uint16_t rrb_gotox_col(int8_t y, int8_t last_but_one_row, uint8_t shift_y)
+{
+  static uint8_t row_masks[8] = {0xff, 0x7f, 0x3f, 0x1f, 0x0f, 0x07, 0x03, 0x01};
+
+  if (y == -1) {
+    return make16(0x98, ~row_masks[shift_y]);
+  }
+  if (y > last_but_one_row) {
+    return make16(0x98, row_masks[shift_y]);
+  }
+  return 0x0090;
+}
+
+/**
+  * @brief Places an object (actor canvas) as rrb layer in the backbuffer rows it covers.
+  *
+  * Each covered row gets a gotox char followed by the object's chars of that row. If the
+  * object starts exactly where the previous object of a row ended, using the same y offset
+  * and row mask, the gotox is omitted and both objects share one gotox span.
+  *
+  * Before anything is written, the free char slots of all covered rows are checked
+  * against RRB_ROW_LIMIT, minus the chars reserved for objects still to be placed on top.
+  * If a row can't take all chars, the object is clipped on its right side. If not even one
+  * column fits, the object is not placed at all.
+  *
+  * @return 1 if the object (or a part of it) was placed, 0 if it was dropped.
+  *
+  * Code section: code_gfx
+  */
+static uint8_t place_rrb_object(uint16_t char_num, int16_t screen_pos_x, int8_t screen_pos_y, uint8_t width_chars, uint8_t height_chars)
+{
+  //debug_out("place rrb object: char_num %d, x %d, y %d, width %d, height %d", char_num, screen_pos_x, screen_pos_y, width_chars, height_chars);
+
+  // place cel using rrb features
+  int8_t char_row = rrb_first_row(screen_pos_y);
+  if (char_row > 15) {
+    return 0;
   }
   screen_pos_x &= 0x3ff;
   int8_t last_but_one_row = height_chars - 2;
@@ -1759,20 +2135,36 @@ static void place_rrb_object(uint16_t char_num, int16_t screen_pos_x, int8_t scr
   if (shift_y) {
     shift_y = 8 - shift_y;
   }
-  else {
-    if (screen_pos_y >= 0) { 
-      --char_row;
-    }
-  }
-  if (char_row > 15) {
-    return;
-  }
 
-  uint8_t  rowmask   = ~row_masks[shift_y];
-  uint16_t gotox_col = make16(0x98, rowmask);
   uint16_t gotox_scr = make16(0, shift_y << 5); // gotox_scr = shift_y << 13
+  uint16_t gotox_scr_first  = screen_pos_x | gotox_scr;
   --char_num;
 
+  // plan: clip width to the free char slots of all covered rows
+  int8_t row = char_row;
+  for (int8_t y = -1; y < height_chars; ++y) {
+    if (row >= 0 && row < 16) {
+      uint16_t col = rrb_gotox_col(y, last_but_one_row, shift_y);
+      uint16_t num_used = num_chars_at_row[row] + rrb_row_reserved[row];
+      uint8_t num_free = num_used < RRB_ROW_LIMIT ? RRB_ROW_LIMIT - num_used : 0;
+      if (rrb_row_next_gotox_scr[row] != gotox_scr_first || rrb_row_last_gotox_col[row] != col) {
+        // gotox needed
+        if (num_free == 0) {
+          return 0;
+        }
+        --num_free;
+      }
+      if (num_free < width_chars) {
+        width_chars = num_free;
+      }
+    }
+    ++row;
+  }
+  if (width_chars == 0) {
+    return 0;
+  }
+  uint16_t gotox_scr_next = ((screen_pos_x + width_chars * 8) & 0x3ff) | gotox_scr;
+
   SAVE_DS_AUTO_RESTORE
   UNMAP_DS
   
@@ -1788,30 +2180,31 @@ static void place_rrb_object(uint16_t char_num, int16_t screen_pos_x, int8_t scr
       uint8_t num_chars_cur_row = num_chars_at_row[char_row];
       __auto_type screen_ptr = screen_start_ptr + num_chars_cur_row;
       __auto_type colram_ptr = colram_start_ptr + num_chars_cur_row;
-      *screen_ptr = screen_pos_x | gotox_scr;
-      *colram_ptr = gotox_col;
-      ++screen_ptr;
-      ++colram_ptr;
+      uint16_t gotox_col = rrb_gotox_col(y, last_but_one_row, shift_y);
+      if (rrb_row_next_gotox_scr[char_row] != gotox_scr_first || rrb_row_last_gotox_col[char_row] != gotox_col) {
+        *screen_ptr = gotox_scr_first;
+        *colram_ptr = gotox_col;
+        ++screen_ptr;
+        ++colram_ptr;
+        ++num_chars_cur_row;
+        rrb_row_last_gotox_col[char_row] = gotox_col;
+      }
       uint16_t cur_char = char_num;
       for (uint8_t x = 0; x < width_chars; ++x) {
         *screen_ptr++ = cur_char;
         *colram_ptr++ = 0xff00;
         cur_char += height_chars;
       }
-      num_chars_at_row[char_row] += width_chars + 1;
+      num_chars_at_row[char_row]       = num_chars_cur_row + width_chars;
+      rrb_row_next_gotox_scr[char_row] = gotox_scr_next;
       screen_start_ptr += CHRCOUNT;
       colram_start_ptr += CHRCOUNT;
     }
-    if (y == last_but_one_row) {
-      rowmask   = row_masks[shift_y];
-      gotox_col = make16(0x98, rowmask);
-    }
-    else if (y == -1) {
-      gotox_col = 0x0090;
-    }
     ++char_num;
     ++char_row;
   }
+
+  return 1;
 }
 
 static void decode_single_mask_column(int16_t col, int8_t y_start, uint8_t num_lines)
@@ -51,10 +51,13 @@ void gfx_set_object_image(uint8_t __huge *src, uint8_t x, uint8_t y, uint8_t wid
 void gfx_clear_dialog(void);
 void gfx_print_dialog(uint8_t color, const char *text, uint8_t num_chars);
 void gfx_draw_bg(uint8_t lights);
+uint8_t gfx_scroll_bg(uint8_t lights);
 void gfx_draw_object(uint8_t local_id, int8_t x, int8_t y);
+void gfx_set_object_clipping(uint8_t first_col, uint8_t last_col);
 void gfx_enable_flashlight(void);
 void gfx_disable_flashlight(void);
 void gfx_flashlight_irq_update(uint8_t enable);
+void gfx_reserve_actor_canvas(int16_t pos_x, int8_t pos_y, uint8_t width, uint8_t height);
 uint8_t gfx_prepare_actor_drawing(int16_t screen_pos_x, int8_t screen_pos_y, uint8_t width, uint8_t height, uint8_t palette);
 void gfx_draw_actor_cel(uint8_t xpos, uint8_t ypos, struct costume_cel *cel_data, uint8_t mirror);
 void gfx_apply_actor_masking(int16_t xpos, int8_t ypos, uint8_t masking);
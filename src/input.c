@@ -19,6 +19,7 @@
 
 #include "input.h"
 #include "io.h"
+#include "replay.h"
 #include "util.h"
 #include "vm.h"
 
@@ -39,6 +40,11 @@ uint8_t  input_cursor_y;
 uint8_t  input_button_pressed;
 uint8_t  input_key_pressed;
 
+uint16_t input_frame_cursor_x;
+uint8_t  input_frame_cursor_y;
+uint8_t  input_frame_button;
+uint8_t  input_frame_key;
+
 static int16_t new_x;
 static int16_t new_y;
 
@@ -102,6 +108,13 @@ void input_update(void)
         :
         : "a", "x", "y", "z");
 
+#if REPLAY == REPLAY_PLAYBACK
+  if (replay_playing) {
+    // input is fed by the replay
+    return;
+  }
+#endif
+
   new_x = input_cursor_x;
   new_y = input_cursor_y;
 
@@ -127,6 +140,28 @@ void input_update(void)
   input_cursor_y = new_y;
 }
 
+/**
+  * @brief Takes the input snapshot for the current frame
+  *
+  * The raster irq keeps updating the input state while the main loop is running. All input
+  * handling of a frame, including replay recording and playback, uses the snapshot taken
+  * here, so input changing in the middle of a frame can't be handled but left unrecorded.
+  * A pending key press is moved into the snapshot, which acknowledges it and lets the irq
+  * queue the next key.
+  *
+  * Code section: code_main
+  */
+void input_sample_frame(void)
+{
+  __disable_interrupts();
+  input_frame_cursor_x = input_cursor_x;
+  input_frame_cursor_y = input_cursor_y;
+  input_frame_button   = input_button_pressed;
+  input_frame_key      = input_key_pressed;
+  input_key_pressed    = 0;
+  __enable_interrupts();
+}
+
 static void handle_joystick(void)
 {
   static uint8_t old_joy1;
@@ -240,6 +275,11 @@ static void handle_keyboard(void)
           case 0xf9:
             input_key_pressed = 5;
             break;
+#if REPLAY == REPLAY_RECORD
+          case 0xf7:
+            input_key_pressed = REPLAY_KEY_SAVE;
+            break;
+#endif
         }
       }
       else if (key_pressed_ascii >= 0x61 && key_pressed_ascii <= 0x7a) {
@@ -31,12 +31,20 @@ extern uint8_t  input_cursor_y;
 extern uint8_t  input_button_pressed;
 extern uint8_t  input_key_pressed;
 
+// input state sampled once per frame by input_sample_frame, used by the main loop
+extern uint16_t input_frame_cursor_x;
+extern uint8_t  input_frame_cursor_y;
+extern uint8_t  input_frame_button;
+extern uint8_t  input_frame_key;
+
 #define HOTSPOT_OFFSET_X 7
 #define HOTSPOT_OFFSET_Y 7
 #define INPUT_CURSOR_X2 (U8(input_cursor_x >> 1))
+#define INPUT_FRAME_CURSOR_X2 (U8(input_frame_cursor_x >> 1))
 
 // code_init functions
 void input_init(void);
 
 // code_main functions
 void input_update(void);
+void input_sample_frame(void);
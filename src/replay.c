@@ -0,0 +1,322 @@
+/* MEGASPUTM - Graphic Adventure Engine for the MEGA65
+ *
+ * Copyright (C) 2023-2024 Robert Steffens
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "replay.h"
+#include "diskio.h"
+#include "error.h"
+#include "input.h"
+#include "io.h"
+#include "map.h"
+#include "util.h"
+#include <string.h>
+
+#ifdef REPLAY
+
+// recorded frames are kept in attic ram, behind the disk cache
+#define REPLAY_BUFFER      0x8400000UL
+#define REPLAY_BUFFER_SIZE 0x40000UL
+
+/**
+  * One entry of the recording. Consecutive frames with identical input and timing
+  * are stored as one entry with a repeat count.
+  */
+struct replay_record {
+  uint8_t  repeat;
+  uint8_t  jiffies;
+  uint16_t cursor_x;
+  uint8_t  cursor_y;
+  uint8_t  button;
+  uint8_t  key;
+};
+
+struct replay_header {
+  char     magic[6];
+  uint16_t seed;
+  uint32_t num_records;
+};
+
+#pragma clang section bss="zdata"
+
+uint8_t replay_playing;
+
+static uint8_t              replay_started;
+static uint16_t             random_state;
+static uint16_t             record_seed;
+static uint32_t             num_records;
+static uint32_t             record_idx;
+static uint32_t             real_jiffies;
+static struct replay_record cur_record;
+
+static void start(void);
+static void append_record(uint8_t jiffies, uint8_t key);
+static struct replay_record __huge *record_ptr(uint32_t idx);
+
+/**
+  * @defgroup replay_public Replay Public Functions
+  * @{
+  */
+#pragma clang section text="code_main" rodata="cdata_main" data="data_main" bss="zdata"
+
+static const char replay_magic[6] = "MMREPL";
+static const char replay_file[]   = "MM.REPLAY";
+
+/**
+  * @brief Records or plays back the input of one frame
+  *
+  * Called once per frame by the main loop, after input_sample_frame and before the input
+  * is handled. When recording, the frame input snapshot and the elapsed jiffies are appended
+  * to the recording. When playing back, the snapshot is overwritten with the recorded values
+  * and the recorded number of jiffies is returned instead of the real one, so scripts see
+  * exactly the same timing as in the recorded session. Once all frames are played back,
+  * input control is given back to the user and the real jiffies spent are written to the
+  * debug output.
+  *
+  * @param elapsed_jiffies The real number of jiffies elapsed since the last frame
+  * @return The number of jiffies the frame should use
+  *
+  * Code section: code_main
+  */
+uint8_t replay_frame(uint8_t elapsed_jiffies)
+{
+  if (!replay_started) {
+    start();
+  }
+
+#if REPLAY == REPLAY_RECORD
+  uint8_t key = input_frame_key;
+  if (key == 0x1f || key == REPLAY_KEY_SAVE) {
+    // the help screen waits for further input on its own and neither showing help nor
+    // saving the recording changes the game state
+    key = 0;
+  }
+
+  // frames with key presses are never merged, as each entry can only hold one key press
+  if (cur_record.repeat != 0 && cur_record.repeat != 0xff && key == 0 &&
+      cur_record.jiffies  == elapsed_jiffies &&
+      cur_record.cursor_x == input_frame_cursor_x &&
+      cur_record.cursor_y == input_frame_cursor_y &&
+      cur_record.button   == input_frame_button &&
+      cur_record.key      == 0) {
+    ++cur_record.repeat;
+    *record_ptr(num_records - 1) = cur_record;
+    return elapsed_jiffies;
+  }
+
+  append_record(elapsed_jiffies, key);
+  return elapsed_jiffies;
+#else
+  if (!replay_playing) {
+    return elapsed_jiffies;
+  }
+
+  real_jiffies += elapsed_jiffies;
+
+  if (cur_record.repeat == 0) {
+    if (record_idx == num_records) {
+      replay_playing = 0;
+      debug_out("Replay of %lu records done, %lu jiffies", num_records, real_jiffies);
+      return elapsed_jiffies;
+    }
+    cur_record = *record_ptr(record_idx++);
+  }
+  --cur_record.repeat;
+
+  // the cursor sprite is positioned by the irq from the live cursor position
+  input_cursor_x       = cur_record.cursor_x;
+  input_cursor_y       = cur_record.cursor_y;
+  input_frame_cursor_x = cur_record.cursor_x;
+  input_frame_cursor_y = cur_record.cursor_y;
+  input_frame_button   = cur_record.button;
+  input_frame_key      = cur_record.key;
+
+  return cur_record.jiffies;
+#endif
+}
+
+/**
+  * @brief Records or plays back a key press read outside of the frame loop
+  *
+  * The pause and restart prompts wait for key presses without running any frames. When
+  * recording, each of those keys is appended to the recording as an entry of its own. When
+  * playing back, the next entry is returned as the key pressed. Returns 0 if the recording
+  * has ended, in which case the key should be read from the keyboard.
+  *
+  * @param key The key pressed by the user (recording only)
+  * @return The key to use
+  *
+  * Code section: code_main
+  */
+uint8_t replay_key(uint8_t key)
+{
+#if REPLAY == REPLAY_RECORD
+  append_record(0, key);
+  return key;
+#else
+  if (!replay_playing) {
+    return 0;
+  }
+  if (record_idx == num_records) {
+    replay_playing = 0;
+    debug_out("Replay of %lu records done, %lu jiffies", num_records, real_jiffies);
+    return 0;
+  }
+  cur_record = *record_ptr(record_idx++);
+  cur_record.repeat = 0;
+  return cur_record.key;
+#endif
+}
+
+/**
+  * @brief Returns the next random number
+  *
+  * Replay builds use this 16-bit xorshift generator instead of the hardware random number
+  * generator, so the sequence is defined by the seed stored in the recording.
+  *
+  * @return The random number (0-255)
+  *
+  * Code section: code_main
+  */
+uint8_t replay_random(void)
+{
+  random_state ^= random_state << 7;
+  random_state ^= random_state >> 9;
+  random_state ^= random_state << 8;
+  return MSB(random_state);
+}
+
+/**
+  * @brief Writes the recording to disk
+  *
+  * The recording is saved as MM.REPLAY, replacing any previous recording. Recording
+  * continues afterwards, so saving again later will write the longer session.
+  *
+  * Code section: code_main
+  */
+void replay_save(void)
+{
+#if REPLAY == REPLAY_RECORD
+  SAVE_CS_AUTO_RESTORE
+  MAP_CS_DISKIO
+
+  struct replay_header header;
+  memcpy(header.magic, replay_magic, sizeof(replay_magic));
+  header.seed        = record_seed;
+  header.num_records = num_records;
+
+  diskio_open_for_writing();
+  diskio_write((uint8_t __huge *)&header, sizeof(header));
+  uint32_t size = num_records * sizeof(struct replay_record);
+  uint8_t __huge *data = (uint8_t __huge *)REPLAY_BUFFER;
+  while (size != 0) {
+    uint16_t chunk = size > 0x8000 ? 0x8000 : (uint16_t)size;
+    diskio_write(data, chunk);
+    data += chunk;
+    size -= chunk;
+  }
+  diskio_close_for_writing(replay_file, FILE_TYPE_SEQ);
+#endif
+}
+
+/// @} // replay_public
+
+//-----------------------------------------------------------------------------------------------
+
+/**
+  * @defgroup replay_private Replay Private Functions
+  * @{
+  */
+
+/**
+  * @brief Starts recording or playback
+  *
+  * Recording seeds the random number generator from the hardware random number generator.
+  * Playback loads MM.REPLAY into the replay buffer. If there is no recording on disk,
+  * the game is played normally.
+  *
+  * Code section: code_main
+  */
+static void start(void)
+{
+  replay_started = 1;
+
+#if REPLAY == REPLAY_RECORD
+  while (RNDRDY & 0x80); // wait for random number generator to be ready
+  random_state = make16(RNDGEN, RNDGEN | 0x01);
+  record_seed  = random_state;
+#else
+  SAVE_CS_AUTO_RESTORE
+  MAP_CS_DISKIO
+
+  random_state = 1;
+  if (!diskio_file_exists(replay_file)) {
+    return;
+  }
+
+  struct replay_header header;
+  diskio_open_for_reading(replay_file, FILE_TYPE_SEQ);
+  diskio_read((uint8_t *)&header, sizeof(header));
+  if (memcmp(header.magic, replay_magic, sizeof(replay_magic)) != 0 ||
+      header.num_records * sizeof(struct replay_record) > REPLAY_BUFFER_SIZE) {
+    fatal_error(ERR_REPLAY_FILE_INVALID);
+  }
+
+  random_state = header.seed;
+  num_records  = header.num_records;
+  for (uint32_t i = 0; i < num_records; ++i) {
+    diskio_read((uint8_t *)&cur_record, sizeof(cur_record));
+    *record_ptr(i) = cur_record;
+  }
+  diskio_close_for_reading();
+
+  cur_record.repeat = 0;
+  replay_playing    = 1;
+#endif
+}
+
+/**
+  * @brief Appends an entry with the frame input snapshot to the recording
+  *
+  * @param jiffies The number of jiffies of the frame
+  * @param key The key pressed
+  *
+  * Code section: code_main
+  */
+static void append_record(uint8_t jiffies, uint8_t key)
+{
+  if ((num_records + 1) * sizeof(struct replay_record) > REPLAY_BUFFER_SIZE) {
+    fatal_error(ERR_REPLAY_BUFFER_FULL);
+  }
+  cur_record.repeat   = 1;
+  cur_record.jiffies  = jiffies;
+  cur_record.cursor_x = input_frame_cursor_x;
+  cur_record.cursor_y = input_frame_cursor_y;
+  cur_record.button   = input_frame_button;
+  cur_record.key      = key;
+  *record_ptr(num_records++) = cur_record;
+}
+
+static struct replay_record __huge *record_ptr(uint32_t idx)
+{
+  return (struct replay_record __huge *)(REPLAY_BUFFER + idx * sizeof(struct replay_record));
+}
+
+/// @} // replay_private
+
+#endif
@@ -0,0 +1,43 @@
+/* MEGASPUTM - Graphic Adventure Engine for the MEGA65
+ *
+ * Copyright (C) 2023-2024 Robert Steffens
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+// Replay builds are selected with -DREPLAY=REPLAY_RECORD or -DREPLAY=REPLAY_PLAYBACK
+// (make CONFIG=record or CONFIG=replay)
+#define REPLAY_RECORD   1
+#define REPLAY_PLAYBACK 2
+
+#ifdef REPLAY
+
+// key code reported by the input module for saving a recording (F7)
+#define REPLAY_KEY_SAVE 7
+
+extern uint8_t replay_playing;
+
+// code_main functions
+uint8_t replay_frame(uint8_t elapsed_jiffies);
+uint8_t replay_key(uint8_t key);
+uint8_t replay_random(void);
+void replay_save(void);
+
+#endif
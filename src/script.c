@@ -25,6 +25,7 @@
 #include "io.h"
 #include "map.h"
 #include "memory.h"
+#include "replay.h"
 #include "resource.h"
 #include "sound.h"
 #include "util.h"
@@ -149,18 +150,22 @@ uint8_t __attribute__((zpage)) parallel_script_count;
 static uint8_t __attribute__((zpage)) opcode;
 static uint8_t __attribute__((zpage)) param_mask;
 static uint8_t * __attribute__((zpage)) pc;
+static uint8_t __attribute__((zpage)) break_script;
 
 //----------------------------------------------------------------------
 
 #pragma clang section bss="zdata"
 
 // private variables
+static const uint8_t bit_masks[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
 static void (*opcode_jump_table[128])(void);
-static uint8_t break_script = 0;
 static uint8_t backup_opcode;
 static uint8_t backup_param_mask;
 static uint8_t *backup_pc;
 static uint8_t backup_break_script;
+#if BACKGROUND_OPCODE_BUDGET
+static uint8_t first_run;
+#endif
 #ifdef DEBUG_SCRIPTS
   uint16_t active_script_id;
 #endif
@@ -489,19 +494,10 @@ void script_stop_slot(uint8_t slot)
 {
   vm_state.proc_state[slot] = PROC_STATE_FREE;
 
-  if (!script_is_room_object_script(slot)) {
+  uint8_t is_global = !script_is_room_object_script(slot);
+  if (is_global) {
     //debug_out("Script %d ended slot %d", vm_state.proc_script_or_object_id[slot], slot);
     res_deactivate_slot(proc_res_slot[slot]);
-
-    for (uint8_t table_idx = 1; table_idx < vm_state.num_active_proc_slots; ++table_idx)
-    {
-      // stop children of us
-      uint8_t child_slot = vm_state.proc_slot_table[table_idx];
-      if (child_slot != 0xff && vm_state.proc_parent[child_slot] == slot) {
-        stop_script_from_table(table_idx);
-      }
-    }
-
   }
   else {
     //debug_out("Object script %d ended slot %d", 
@@ -509,11 +505,21 @@ void script_stop_slot(uint8_t slot)
     //           slot);
   }
 
-  // Mark all stopped scripts as 0xff in slot table
+  // Stop children of us and mark all stopped scripts as 0xff in slot table in a single pass.
+  // Slots are reused, so a child can be anywhere in the table, and each one is found when
+  // the loop reaches it. Its own children are stopped by stop_script_from_table, which only
+  // searches the table after the child's entry. Everything freed by it is therefore still
+  // ahead of the loop and gets marked when the loop reaches it.
   for (uint8_t table_idx = 0; table_idx < vm_state.num_active_proc_slots; ++table_idx)
   {
     uint8_t tmp_slot = vm_state.proc_slot_table[table_idx];
-    if (tmp_slot != 0xff && vm_state.proc_state[tmp_slot] == PROC_STATE_FREE) {
+    if (tmp_slot == 0xff) {
+      continue;
+    }
+    if (is_global && table_idx != 0 && vm_state.proc_parent[tmp_slot] == slot) {
+      stop_script_from_table(table_idx);
+    }
+    if (vm_state.proc_state[tmp_slot] == PROC_STATE_FREE) {
       vm_state.proc_slot_table[table_idx] = 0xff;
     }
   }
@@ -651,6 +657,13 @@ static uint8_t run_active_slot(void)
   }
   pc = NEAR_U8_PTR(RES_MAPPED) + vm_state.proc_pc[active_script_slot];
   ++proc_exec_count[active_script_slot];
+#if BACKGROUND_OPCODE_BUDGET
+  // only background scripts scheduled by the main loop are suspended, scripts started from
+  // another script or started synchronously (e.g. by execute_sentence_stack) still run their
+  // first cycle like a subroutine
+  uint8_t budgeted = parallel_script_count == 1 && !first_run &&
+                     (vm_state.proc_type[active_script_slot] & PROC_TYPE_BACKGROUND);
+#endif
   // check for PROC_STATE_RUNNING only will also mean we won't continue executing if
   // PROC_FLAGS_FROZEN is set.
   while (vm_get_active_proc_state_and_flags() == PROC_STATE_RUNNING && !(break_script)) {
@@ -665,6 +678,12 @@ static uint8_t run_active_slot(void)
       opcode);
 #endif
     exec_opcode(opcode);
+#if BACKGROUND_OPCODE_BUDGET
+    // checked after the opcode, so background scripts make progress in every frame
+    if (++frame_opcode_count >= BACKGROUND_OPCODE_BUDGET && budgeted) {
+      break;
+    }
+#endif
   }
 
   vm_state.proc_pc[active_script_slot] = (uint16_t)(pc - NEAR_U8_PTR(RES_MAPPED));
@@ -703,7 +722,14 @@ static uint8_t run_slot_stacked(uint8_t slot)
 static void run_script_first_time(uint8_t slot)
 {
   // execute new script immediately (like subroutine)
+#if BACKGROUND_OPCODE_BUDGET
+  uint8_t save_first_run = first_run;
+  first_run = 1;
+  script_execute_slot(slot);
+  first_run = save_first_run;
+#else
   script_execute_slot(slot);
+#endif
 
   if (vm_state.proc_state[slot] != PROC_STATE_FREE) {
     // script hit first break and is still running, put it into slot table for scheduling next cycle
@@ -820,7 +846,15 @@ static uint8_t find_matching_running_script(uint8_t type_mask, uint8_t type_matc
 static uint8_t read_byte(void)
 {
   uint8_t value;
-  value = *pc++;
+
+  // value = *pc++;
+  __asm (" ldy #0\n"
+         " lda (pc),y\n"
+         " inw pc"
+         : "=Ka" (value)
+         :
+         : "y");
+
   return value;
 }
 
@@ -1350,7 +1384,7 @@ static void owner_of(void)
   uint8_t var_idx = read_byte();
   uint16_t obj_id = resolve_next_param16();
   //debug_scr("owner-of %d is %d", obj_id, vm_state.global_game_objects[obj_id] & 0x0f);
-  vm_write_var(var_idx, vm_state.global_game_objects[obj_id] & 0x0f);
+  vm_write_var8(var_idx, vm_state.global_game_objects[obj_id] & 0x0f);
 }
 
 static void do_animation(void)
@@ -1477,8 +1511,12 @@ static void random_number(void)
   uint8_t var_idx = read_byte();
   uint8_t upper_bound = resolve_next_param8();
   //debug_scr("VAR[%d] = random %d", var_idx, upper_bound);
+#ifdef REPLAY
+  uint8_t rnd_number = (replay_random() * (upper_bound + 1)) >> 8;
+#else
   while (RNDRDY & 0x80); // wait for random number generator to be ready
   uint8_t rnd_number = (RNDGEN * (upper_bound + 1)) >> 8;
+#endif
   vm_write_var(var_idx, rnd_number);
 }
 
@@ -1544,13 +1582,17 @@ static void assign_bit_variable(void)
   uint16_t bit_var_hi = read_word() + resolve_next_param8();
   uint8_t bit_var_lo = bit_var_hi & 0x0f;
   bit_var_hi >>= 4;
+  // bits 0-7 are stored in the low byte of the variable, bits 8-15 in the high byte
+  uint8_t *var_byte = (bit_var_lo & 0x08) ? &vm_state.variables_hi[LSB(bit_var_hi)]
+                                          : &vm_state.variables_lo[LSB(bit_var_hi)];
+  uint8_t mask = bit_masks[bit_var_lo & 0x07];
   if (resolve_next_param8()) {
     //debug_scr("set bit variable %x.%x", bit_var_hi, bit_var_lo);
-    vm_write_var(bit_var_hi, vm_read_var(bit_var_hi) | (1 << bit_var_lo));
+    *var_byte |= mask;
   }
   else {
     //debug_scr("clear bit variable %x.%x", bit_var_hi, bit_var_lo);
-    vm_write_var(bit_var_hi, vm_read_var(bit_var_hi) & ~(1 << bit_var_lo));
+    *var_byte &= ~mask;
   }
 }
 
@@ -1654,10 +1696,10 @@ static void come_out_door(void)
   // we must not access any further script bytes anymore past this point.
   vm_set_current_room(new_room_id);
 
-  __auto_type obj_hdr = vm_get_room_object_hdr(arrive_at_object_id);
-  uint8_t x = obj_hdr->walk_to_x;
-  uint8_t y = (obj_hdr->walk_to_y_and_preposition & 0x1f) << 2;
-  uint8_t dir = actor_invert_direction(obj_hdr->height_and_actor_dir & 0x03);
+  uint8_t local_object_id = vm_get_local_object_id(arrive_at_object_id);
+  uint8_t x = room_objects.walk_to_x[local_object_id];
+  uint8_t y = (room_objects.walk_to_y_and_preposition[local_object_id] & 0x1f) << 2;
+  uint8_t dir = actor_invert_direction(room_objects.actor_dir[local_object_id]);
   actor_place_at(actor_id, x, y);
   actor_change_direction(actors.local_id[actor_id], dir);
   actor_stop_and_turn(actor_id, dir);
@@ -1690,13 +1732,13 @@ static void jump_if_or_if_not_equal_zero(void)
   int16_t offset = read_word();
   if (opcode & param_mask) {
     //debug_msg("Jump if equal zero");
-    if (vm_read_var(var_idx) == 0) {
+    if (vm_is_var_zero(var_idx)) {
       pc += offset;
     }
   }
   else {
     //debug_msg("Jump if not equal zero");
-    if (vm_read_var(var_idx) != 0) {
+    if (!vm_is_var_zero(var_idx)) {
       pc += offset;
     }
   }
@@ -1789,6 +1831,7 @@ static void sleep_for_or_wait_for_message(void)
     if (vm_read_var8(VAR_MESSAGE_GOING)) {
       --pc;
       break_script = 1;
+      vm_wait_for_event(EVENT_MESSAGE_DONE);
     }
   }
 }
@@ -1815,9 +1858,7 @@ static void set_box(void)
   uint8_t box_id = resolve_next_param8();
   uint8_t class  = read_byte();
   //debug_out("set-box %d to %d", box_id, class);
-  SAVE_DS_AUTO_RESTORE
-  map_ds_resource(room_res_slot);
-  walk_boxes[box_id].classes = class;
+  walkbox_set_box_classes(box_id, class);
 }
 
 /**
@@ -1838,7 +1879,9 @@ static void assign_from_bit_variable(void)
   uint8_t bit_var_lo = bit_var_hi & 0x0f;
   bit_var_hi >>= 4;
   //debug_scr("VAR[%d] = bit-variable %x.%x", var_idx, bit_var_hi, bit_var_lo);
-  vm_write_var(var_idx, (vm_read_var(bit_var_hi) >> bit_var_lo) & 1);
+  uint8_t var_byte = (bit_var_lo & 0x08) ? vm_state.variables_hi[LSB(bit_var_hi)]
+                                         : vm_state.variables_lo[LSB(bit_var_hi)];
+  vm_write_var8(var_idx, (var_byte & bit_masks[bit_var_lo & 0x07]) != 0);
 }
 
 static void camera_at(void)
@@ -2013,11 +2056,12 @@ static void wait_for_actor(void)
 
   uint8_t walk_state = local_actors.walking[local_id];
   if (walk_state != WALKING_STATE_FINISHED && walk_state != WALKING_STATE_STOPPED) {
-    // if actor is still moving, we break the script for one cycle
+    // if actor is still moving, we suspend the script until the actor stopped walking
     // but need to make sure we execute this opcode again
     // so we set the pc back to the opcode
     pc -= 2;
     break_script = 1;
+    vm_wait_for_event(actor_id);
   }
 }
 
@@ -2481,13 +2525,15 @@ static void preposition(void)
   SAVE_DS_AUTO_RESTORE
   uint8_t preposition = 0xff;
   struct object_code *obj_hdr = inv_get_object_by_id(obj_id);
-  if (obj_hdr == NULL) {
-    obj_hdr = vm_get_room_object_hdr(obj_id);
-  }
-
   if (obj_hdr != NULL) {
     preposition = obj_hdr->walk_to_y_and_preposition >> 5;
   }
+  else {
+    uint8_t local_object_id = vm_get_local_object_id(obj_id);
+    if (local_object_id != 0xff) {
+      preposition = room_objects.walk_to_y_and_preposition[local_object_id] >> 5;
+    }
+  }
 
   vm_write_var(var_idx, preposition);
 }
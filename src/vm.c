@@ -28,6 +28,7 @@
 #include "io.h"
 #include "map.h"
 #include "memory.h"
+#include "replay.h"
 #include "resource.h"
 #include "script.h"
 #include "sound.h"
@@ -57,6 +58,11 @@ struct room_header {
   uint16_t entry_script_offset;  
 };
 
+#pragma clang section bss="zzpage"
+
+// hot interpreter state, kept in zero page
+uint8_t __attribute__((zpage)) active_script_slot;
+
 #pragma clang section bss="zdata"
 
 struct vm vm_state;
@@ -67,16 +73,30 @@ uint8_t lang;
 uint8_t restart_key_yes;
 
 volatile uint8_t script_watchdog;
+#if BACKGROUND_OPCODE_BUDGET
+uint16_t frame_opcode_count;
+#endif
 uint8_t ui_state;
 uint16_t camera_x;
+uint8_t camera_fine_x;
 uint16_t camera_target;
 uint8_t camera_state;
 uint8_t camera_follow_actor_id;
 
 int8_t   proc_slot_table_idx;
 uint8_t  proc_slot_table_exec;
+
+// slots waiting for their timer, jiffies are only applied to their timers when one can wake up
+uint8_t  num_sleeping_slots;
+uint8_t  sleeping_slots[NUM_SCRIPT_SLOTS];
+int32_t  timer_pending_jiffies;
+int32_t  timer_next_wakeup;
+
+// event each slot is waiting for in PROC_STATE_WAITING_FOR_EVENT
+uint8_t  proc_wait_event[NUM_SCRIPT_SLOTS];
+uint8_t  num_event_waits;   // upper bound of slots waiting for an event
+
 uint8_t  proc_table_cleanup_needed;
-uint8_t  active_script_slot;
 uint16_t message_timer;
 uint8_t  actor_talking;
 
@@ -93,6 +113,9 @@ uint8_t  num_objects;
 uint8_t  obj_page[MAX_OBJECTS];
 uint8_t  obj_offset[MAX_OBJECTS];
 uint16_t obj_id[MAX_OBJECTS];
+room_objects_t room_objects;
+// bitset of local objects overlapping each horizontal room section
+uint8_t  obj_buckets[NUM_OBJ_BUCKETS][OBJ_BUCKET_BYTES];
 uint8_t  screen_update_needed;
 uint8_t  ntsc;
 
@@ -127,11 +150,16 @@ static void process_dialog(uint8_t jiffies_elapsed);
 static void stop_current_actor_talking(void);
 static void stop_all_dialog(void);
 static uint8_t wait_for_jiffy(void);
+static uint8_t wait_for_key(void);
 static void read_objects(void);
 static void redraw_screen(void);
+static void scroll_screen(void);
+static void draw_room_objects(int8_t first_col, int8_t last_col);
 static void handle_input(void);
 static uint8_t match_parent_object_state(uint8_t parent, uint8_t expected_state);
 static void update_script_timers(uint8_t elapsed_jiffies);
+static void flush_script_timers(void);
+static void reset_script_timers(void);
 static const char *get_object_name(uint16_t global_object_id);
 static uint8_t start_child_script_at_address(uint8_t script_slot, uint8_t res_slot, uint16_t offset);
 static void execute_sentence_stack(void);
@@ -163,6 +191,7 @@ static void cleanup_slot_table();
 static void read_walk_boxes(void);
 static void clear_all_other_object_states(uint8_t local_object_id);
 static void update_camera(void);
+static void align_camera_to_char(void);
 static uint8_t get_hovered_verb_slot(void);
 static void verb_new(uint8_t slot, uint8_t verb_id, uint8_t x, uint8_t y, const char* name);
 static void verb_delete(uint8_t slot);
@@ -216,6 +245,7 @@ void vm_init(void)
   }
 
   camera_x = 20;
+  camera_fine_x = 0;
   camera_state = 0;
   camera_follow_actor_id = 0xff;
   actor_talking = 0xff;
@@ -300,6 +330,11 @@ __task void vm_mainloop(void)
       elapsed_jiffies = 15;
     }
 
+    input_sample_frame();
+#ifdef REPLAY
+    elapsed_jiffies = replay_frame(elapsed_jiffies);
+#endif
+
     //VICIV.bordercol = 0x01;
 
     MAP_CS_DISKIO
@@ -313,9 +348,16 @@ __task void vm_mainloop(void)
     handle_input();
 
     update_script_timers(elapsed_jiffies);
+    // messages can also be ended by scripts writing the variable directly
+    if (num_event_waits && !vm_read_var8(VAR_MESSAGE_GOING)) {
+      vm_signal_event(EVENT_MESSAGE_DONE);
+    }
 
     //debug_out("New cycle, %d scripts active", vm_state.num_active_proc_slots);
     memset(proc_exec_count, 0, NUM_SCRIPT_SLOTS);
+#if BACKGROUND_OPCODE_BUDGET
+    frame_opcode_count   = 0;
+#endif
     proc_slot_table_exec = 0;
     for (proc_slot_table_idx = 0; 
          proc_slot_table_idx < vm_state.num_active_proc_slots;
@@ -390,6 +432,9 @@ __task void vm_mainloop(void)
       if (screen_update_needed & SCREEN_UPDATE_BG) {
         redraw_screen();
       }
+      else if (screen_update_needed & SCREEN_UPDATE_SCROLL) {
+        scroll_screen();
+      }
       if (screen_update_needed & SCREEN_UPDATE_ACTORS) {
         actor_sort_and_draw_all();
       }
@@ -406,7 +451,7 @@ __task void vm_mainloop(void)
         }
       }
 
-      if (screen_update_needed & (SCREEN_UPDATE_BG | SCREEN_UPDATE_ACTORS)) {
+      if (screen_update_needed & (SCREEN_UPDATE_BG | SCREEN_UPDATE_SCROLL | SCREEN_UPDATE_ACTORS)) {
         gfx_update_main_screen();
       }
 
@@ -569,6 +614,7 @@ void vm_set_current_room(uint8_t room_no)
     // activate new room data
     load_room(room_no);
     camera_x = 20;
+    camera_fine_x = 0;
     vm_write_var(VAR_CAMERA_X, camera_x);
     actor_room_changed();
 
@@ -586,6 +632,24 @@ void vm_set_current_room(uint8_t room_no)
   UNMAP_CS
 }
 
+/**
+  * @brief Returns the offset of the script handling a verb for an object
+  *
+  * Scans the verb table of the object, which is a list of verb id and script offset pairs
+  * terminated by 0. A verb id of 0xff matches any verb. Room objects are read from the room
+  * resource, inventory objects from their copy on the heap.
+  *
+  * The tables are scanned directly instead of being cached at room load. The function is
+  * only called when a sentence gets executed (execute_sentence_stack and
+  * script_execute_object_script), never per frame, and the tables only have a few entries.
+  *
+  * @param verb The verb id to look for
+  * @param local_object_id Local id of the room object or inventory position of the object
+  * @param is_inventory 1 if local_object_id is an inventory position
+  * @return The script offset relative to the object header, or 0 if there is no script
+  *
+  * Code section: code_main
+  */
 uint8_t vm_get_room_object_script_offset(uint8_t verb, uint8_t local_object_id, uint8_t is_inventory)
 {
   SAVE_DS_AUTO_RESTORE
@@ -637,8 +701,69 @@ uint8_t vm_get_room_object_script_offset(uint8_t verb, uint8_t local_object_id,
   */
 void vm_set_script_wait_timer(int32_t negative_ticks)
 {
+  // jiffies already pending for the other sleeping slots must not count for this one
+  int32_t timer = negative_ticks - timer_pending_jiffies;
   vm_state.proc_state[active_script_slot] = PROC_STATE_WAITING_FOR_TIMER;
-  vm_state.proc_wait_timer[active_script_slot] = negative_ticks;
+  vm_state.proc_wait_timer[active_script_slot] = timer;
+
+  uint8_t i = 0;
+  while (i != num_sleeping_slots && sleeping_slots[i] != active_script_slot) {
+    ++i;
+  }
+  if (i == num_sleeping_slots) {
+    sleeping_slots[num_sleeping_slots++] = active_script_slot;
+  }
+
+  if (1 - timer < timer_next_wakeup) {
+    timer_next_wakeup = 1 - timer;
+  }
+}
+
+/**
+  * @brief Suspends the currently active script until an event gets signalled
+  *
+  * The script won't be executed again until vm_signal_event is called with the same event.
+  * Scripts are expected to rewind their pc to the waiting opcode, so the condition is checked
+  * again when the script continues.
+  *
+  * @param event The event to wait for (actor id or EVENT_MESSAGE_DONE)
+  *
+  * Code section: code_main
+  */
+void vm_wait_for_event(uint8_t event)
+{
+  vm_state.proc_state[active_script_slot] = PROC_STATE_WAITING_FOR_EVENT;
+  proc_wait_event[active_script_slot]     = event;
+  ++num_event_waits;
+}
+
+/**
+  * @brief Wakes up all scripts waiting for the given event
+  *
+  * Frozen scripts keep their frozen flag and will continue once they get unfrozen.
+  *
+  * @param event The event that occurred (actor id or EVENT_MESSAGE_DONE)
+  *
+  * Code section: code_main
+  */
+void vm_signal_event(uint8_t event)
+{
+  if (!num_event_waits) {
+    return;
+  }
+
+  uint8_t num_waits = 0;
+  for (uint8_t slot = 0; slot < NUM_SCRIPT_SLOTS; ++slot) {
+    if ((vm_state.proc_state[slot] & 0x07) == PROC_STATE_WAITING_FOR_EVENT) {
+      if (proc_wait_event[slot] == event) {
+        set_proc_state(slot, PROC_STATE_RUNNING);
+      }
+      else {
+        ++num_waits;
+      }
+    }
+  }
+  num_event_waits = num_waits;
 }
 
 /**
@@ -817,8 +942,9 @@ struct object_code *vm_get_room_object_hdr(uint16_t global_object_id)
   * @brief Returns the object id at the given position
   *
   * Returns the object id of the object at the given position. The function will iterate over
-  * all objects and check if the object is currently active and if the object position matches
-  * the one provided. If a match is found, the object id is returned.
+  * all objects in the hit-test bucket of the x position and check if the object is currently
+  * active and if the object position matches the one provided. If a match is found, the object
+  * id is returned.
   *
   * @param x The x position of the object in scene coordinates
   * @param y The y position of the object in scene coordinates
@@ -828,34 +954,47 @@ struct object_code *vm_get_room_object_hdr(uint16_t global_object_id)
   */
 uint16_t vm_get_object_at(uint8_t x, uint8_t y)
 {
-  SAVE_DS_AUTO_RESTORE
-
   uint16_t found_obj_id = 0;
   y >>= 2;
 
+  __auto_type bucket = obj_buckets[x >> OBJ_BUCKET_SHIFT];
+  uint8_t bits = 0;
 
   for (uint8_t i = 0; i < num_objects; ++i) {
-    map_ds_resource(obj_page[i]);
-    __auto_type obj_hdr = (struct object_code *)(RES_MAPPED + obj_offset[i]);
-    //debug_out("Checking object %d at %d, %d state %d - parent_state %d", obj_hdr->id, obj_hdr->pos_x, obj_hdr->pos_y_and_parent_state & 0x7f, vm_state.global_game_objects[obj_hdr->id] & OBJ_STATE, obj_hdr->pos_y_and_parent_state & 0x80);
-    //debug_out("  obj_state %x", vm_state.global_game_objects[obj_hdr->id]);
-    if (vm_state.global_game_objects[obj_hdr->id] & OBJ_CLASS_UNTOUCHABLE) {
+    if (!(i & 0x07)) {
+      bits = bucket[i >> 3];
+      if (!bits) {
+        // no objects in this group of 8
+        i += 7;
+        continue;
+      }
+    }
+    uint8_t in_bucket = bits & 0x01;
+    bits >>= 1;
+    if (!in_bucket) {
+      continue;
+    }
+
+    //debug_out("Checking object %d at %d, %d state %d - parent_state %d", obj_id[i], room_objects.pos_x[i], room_objects.pos_y_and_parent_state[i] & 0x7f, vm_state.global_game_objects[obj_id[i]] & OBJ_STATE, room_objects.pos_y_and_parent_state[i] & 0x80);
+    //debug_out("  obj_state %x", vm_state.global_game_objects[obj_id[i]]);
+    if (vm_state.global_game_objects[obj_id[i]] & OBJ_CLASS_UNTOUCHABLE) {
       continue;
     }
-    if (obj_hdr->parent != 0) {
-      if (!match_parent_object_state(obj_hdr->parent - 1, obj_hdr->pos_y_and_parent_state & 0x80)) {
+    uint8_t parent = room_objects.parent[i];
+    if (parent != 0) {
+      if (!match_parent_object_state(parent - 1, room_objects.pos_y_and_parent_state[i] & 0x80)) {
         continue;
       }
     }
 
-    uint8_t width  = obj_hdr->width;
-    uint8_t height = obj_hdr->height_and_actor_dir >> 3;
-    uint8_t obj_x  = obj_hdr->pos_x;
-    uint8_t obj_y  = obj_hdr->pos_y_and_parent_state & 0x7f;
+    uint8_t width  = room_objects.width[i];
+    uint8_t height = room_objects.height[i];
+    uint8_t obj_x  = room_objects.pos_x[i];
+    uint8_t obj_y  = room_objects.pos_y_and_parent_state[i] & 0x7f;
 
     if (x >= obj_x && x < obj_x + width && y >= obj_y && y < obj_y + height)
     {
-      found_obj_id = obj_hdr->id;
+      found_obj_id = obj_id[i];
       break;
     }
   }
@@ -865,8 +1004,6 @@ uint16_t vm_get_object_at(uint8_t x, uint8_t y)
 
 uint8_t vm_get_object_position(uint16_t global_object_id, uint8_t *x, uint8_t *y)
 {
-  SAVE_DS_AUTO_RESTORE
-
   // check if object is an actor
   if (global_object_id <= NUM_ACTORS) {
     // in current room?
@@ -879,12 +1016,12 @@ uint8_t vm_get_object_position(uint16_t global_object_id, uint8_t *x, uint8_t *y
   }
 
   // check if object is in current room
-  __auto_type obj_hdr = vm_get_room_object_hdr(global_object_id);
-  if (!obj_hdr) {
+  uint8_t local_id = vm_get_local_object_id(global_object_id);
+  if (local_id == 0xff) {
     return 0;
   }
-  *x = obj_hdr->pos_x;
-  *y = obj_hdr->pos_y_and_parent_state & 0x7f;
+  *x = room_objects.pos_x[local_id];
+  *y = room_objects.pos_y_and_parent_state[local_id] & 0x7f;
   return 2;
 }
 
@@ -967,22 +1104,19 @@ void vm_draw_object(uint8_t local_id, uint8_t x, uint8_t y)
   MAP_CS_MAIN_PRIV
   clear_all_other_object_states(local_id);
 
-  map_ds_resource(obj_page[local_id]);
-  __auto_type obj_hdr = (struct object_code *)NEAR_U8_PTR(RES_MAPPED + obj_offset[local_id]);
-  
-  uint8_t width  = obj_hdr->width;
-  uint8_t height = obj_hdr->height_and_actor_dir >> 3;
+  uint8_t width  = room_objects.width[local_id];
+  uint8_t height = room_objects.height[local_id];
 
   if (x == 0xff) {
-    x = obj_hdr->pos_x;
+    x = room_objects.pos_x[local_id];
   }
   if (y == 0xff) {
-    y = obj_hdr->pos_y_and_parent_state & 0x7f;
+    y = room_objects.pos_y_and_parent_state[local_id] & 0x7f;
   }
 
   int8_t screen_x = (int8_t)x - camera_x + 20;
 
-  if (screen_x >= 40 || screen_x + width <= 0 || y >= 16) {
+  if (screen_x >= 41 || screen_x + width <= 0 || y >= 16) {
     return;
   }
 
@@ -1022,6 +1156,7 @@ void vm_camera_at(uint8_t x)
 void vm_set_camera_to(uint8_t x)
 {
   camera_x = clamp_camera_x(x);
+  camera_fine_x = 0;
   vm_write_var(VAR_CAMERA_X, camera_x);
   vm_update_bg();
   vm_update_actors();
@@ -1156,6 +1291,7 @@ uint8_t vm_save_game(uint8_t slot)
   diskio_write((uint8_t __huge *)&version, 1);
 
   // write global vm state
+  flush_script_timers();
   diskio_write((uint8_t __huge *)&vm_state, sizeof(vm_state));
 
   // write inventory objects
@@ -1220,6 +1356,7 @@ uint8_t vm_load_game(uint8_t slot)
 
   // read data from disk
   diskio_read((uint8_t *)&vm_state, sizeof(vm_state));
+  reset_script_timers();
 
   // read inventory objects
   map_ds_resource(heap_slot);
@@ -1350,6 +1487,7 @@ static void reset_game_state(void)
     vm_state.proc_parent[i]              = 0xff;
     vm_state.proc_wait_timer[i]          = 0;
   }
+  reset_script_timers();
 
   UNMAP_DS
   for (uint8_t i = 0; i < MAX_VERBS; ++i) {
@@ -1375,7 +1513,8 @@ static void reset_game_state(void)
     actors.local_id[i]    = 0xff;
     actors.palette_idx[i] = 1; // default actor palette is index 1
     if (i < MAX_LOCAL_ACTORS) {
-      local_actors.global_id[i] = 0xff;
+      local_actors.global_id[i]  = 0xff;
+      local_actors.draw_order[i] = 0xff;
     }
   }
 
@@ -1385,6 +1524,7 @@ static void reset_game_state(void)
 
   active_script_slot         = 0xff;
   camera_x                   = 20;
+  camera_fine_x              = 0;
   camera_state               = 0;
   camera_follow_actor_id     = 0xff;
   actor_talking              = 0xff;
@@ -1496,6 +1636,7 @@ static void stop_current_actor_talking(void)
   vm_update_dialog();
   vm_write_var(VAR_MESSAGE_GOING, 0);
   vm_write_var(VAR_MSGLEN, 0);
+  vm_signal_event(EVENT_MESSAGE_DONE);
 }
 
 static void stop_all_dialog(void)
@@ -1508,6 +1649,7 @@ static void stop_all_dialog(void)
   actor_stop_talking(0xff);
   vm_write_var(VAR_MESSAGE_GOING, 0);
   vm_write_var(VAR_MSGLEN, 0);
+  vm_signal_event(EVENT_MESSAGE_DONE);
 }
 
 /**
@@ -1529,6 +1671,38 @@ static uint8_t wait_for_jiffy(void)
   return num_jiffies_elapsed;
 }
 
+/**
+  * @brief Waits for a key press outside of the frame loop
+  *
+  * Used by the pause and restart prompts. The key press is acknowledged before returning.
+  * Replay builds record the key or take it from the recording, so prompts get replayed as
+  * well.
+  *
+  * @return The key pressed
+  *
+  * Code section: code_main
+  */
+static uint8_t wait_for_key(void)
+{
+  uint8_t key;
+#if REPLAY == REPLAY_PLAYBACK
+  if ((key = replay_key(0)) != 0) {
+    return key;
+  }
+#endif
+  while (1) {
+    if (input_key_pressed) {
+      key = input_key_pressed;
+      input_key_pressed = 0;
+      break;
+    }
+  }
+#if REPLAY == REPLAY_RECORD
+  replay_key(key);
+#endif
+  return key;
+}
+
 /**
   * @brief Reads object data for the current room
   *
@@ -1537,7 +1711,8 @@ static uint8_t wait_for_jiffy(void)
   * offsets and image offsets from the room resource. The function will then read the object
   * metadata and image data for each object and store it in the object data arrays.
   *
-  * The images are decoded and kept in gfx memory for fast drawing on screen.
+  * Memory for the images is reserved in gfx memory. The images are decoded when they get
+  * drawn for the first time and are then kept for fast drawing on screen.
   *
   * Needs cs_gfx mapped and the room resource mapped to DS.
   *
@@ -1558,6 +1733,8 @@ static void read_objects(void)
   uint16_t *image_offset = NEAR_U16_PTR(RES_MAPPED + sizeof(struct room_header));
   struct offset *obj_hdr_offset = (struct offset *)(image_offset + num_objects);
 
+  memset(obj_buckets, 0, sizeof(obj_buckets));
+
   for (uint8_t i = 0; i < num_objects; ++i)
   {
     // read object and image offsets
@@ -1573,6 +1750,23 @@ static void read_objects(void)
     map_ds_resource(cur_obj_page);
     __auto_type obj_hdr = (struct object_code *)NEAR_U8_PTR(RES_MAPPED + cur_obj_offset);
     obj_id[i] = obj_hdr->id;
+    room_objects.pos_x[i]                     = obj_hdr->pos_x;
+    room_objects.pos_y_and_parent_state[i]    = obj_hdr->pos_y_and_parent_state;
+    room_objects.width[i]                     = obj_hdr->width;
+    room_objects.height[i]                    = obj_hdr->height_and_actor_dir >> 3;
+    room_objects.parent[i]                    = obj_hdr->parent;
+    room_objects.walk_to_x[i]                 = obj_hdr->walk_to_x;
+    room_objects.walk_to_y_and_preposition[i] = obj_hdr->walk_to_y_and_preposition;
+    room_objects.actor_dir[i]                 = obj_hdr->height_and_actor_dir & 0x03;
+    room_objects.name_offset[i]               = obj_hdr->name_offset;
+
+    // add object to all hit-test buckets it overlaps
+    uint8_t first_bucket = obj_hdr->pos_x >> OBJ_BUCKET_SHIFT;
+    uint8_t last_bucket  = min(obj_hdr->pos_x + obj_hdr->width - 1, 255) >> OBJ_BUCKET_SHIFT;
+    uint8_t obj_bit      = 1 << (i & 0x07);
+    for (uint8_t b = first_bucket; b <= last_bucket; ++b) {
+      obj_buckets[b][i >> 3] |= obj_bit;
+    }
 
     // read object image
     gfx_set_object_image(room_ptr + cur_image_offset, 
@@ -1605,25 +1799,66 @@ static void redraw_screen(void)
   gfx_draw_bg(vm_read_var8(VAR_CURRENT_LIGHTS) == 11);
 
   // draw all visible room objects
+  draw_room_objects(0, 40);
+}
+
+/**
+  * @brief Scrolls the screen to the current camera position
+  *
+  * Only the newly exposed background column gets drawn, together with all room objects
+  * covering it. Falls back to a full redraw if the camera jumped by more than one char.
+  *
+  * @note This function will change CS and DS but won't restore them.
+  *
+  * Code section: code_main
+  */
+static void scroll_screen(void)
+{
+  MAP_CS_GFX
+
+  uint8_t col = gfx_scroll_bg(vm_read_var8(VAR_CURRENT_LIGHTS) == 11);
+  if (col == 0xff) {
+    draw_room_objects(0, 40);
+  }
+  else if (col != 0xfe) {
+    gfx_set_object_clipping(col, col);
+    draw_room_objects(col, col);
+    gfx_set_object_clipping(0, 40);
+  }
+}
+
+/**
+  * @brief Draws all visible room objects overlapping the given screen columns
+  *
+  * @param first_col First screen column (0-40) to draw objects for.
+  * @param last_col Last screen column (0-40) to draw objects for.
+  *
+  * @note This function will change DS but won't restore it.
+  *
+  * Code section: code_main
+  */
+static void draw_room_objects(int8_t first_col, int8_t last_col)
+{
+  // backbuffer is hidden while DS is mapped to a resource
+  UNMAP_DS
+
   for (int8_t i = num_objects - 1; i >= 0; --i)
   {
-    map_ds_resource(obj_page[i]);
-    __auto_type obj_hdr = (struct object_code *)NEAR_U8_PTR(RES_MAPPED + obj_offset[i]);
     // OBJ_STATE is used to determine visibility of object in this room
-    if (!(vm_state.global_game_objects[obj_hdr->id] & OBJ_STATE)) {
+    if (!(vm_state.global_game_objects[obj_id[i]] & OBJ_STATE)) {
       continue;
     }
-    if (obj_hdr->parent != 0) {
-      if (!match_parent_object_state(obj_hdr->parent - 1, obj_hdr->pos_y_and_parent_state & 0x80)) {
+    uint8_t parent = room_objects.parent[i];
+    if (parent != 0) {
+      if (!match_parent_object_state(parent - 1, room_objects.pos_y_and_parent_state[i] & 0x80)) {
         continue;
       }
     }
-    int8_t screen_x = obj_hdr->pos_x - camera_x + 20;
-    if (screen_x >= 40 || screen_x + obj_hdr->width <= 0) {
+    int8_t screen_x = room_objects.pos_x[i] - camera_x + 20;
+    if (screen_x > last_col || screen_x + room_objects.width[i] <= first_col) {
       continue;
     }
-    int8_t screen_y = obj_hdr->pos_y_and_parent_state & 0x7f;
-    UNMAP_DS
+    int8_t screen_y = room_objects.pos_y_and_parent_state[i] & 0x7f;
 
     gfx_draw_object(i, screen_x, screen_y);
   }
@@ -1633,13 +1868,13 @@ static void handle_input(void)
 {
   // mouse cursor handling
   static uint8_t last_input_button_pressed = 0;
-  uint8_t current_button_pressed = input_button_pressed;
-  uint8_t current_key_pressed    = input_key_pressed;
+  uint8_t current_button_pressed = input_frame_button;
+  uint8_t current_key_pressed    = input_frame_key;
 
   uint8_t camera_offset = camera_x - 20;
 
-  vm_write_var(VAR_SCENE_CURSOR_X, (INPUT_CURSOR_X2 >> 2) + camera_offset);
-  vm_write_var(VAR_SCENE_CURSOR_Y, (input_cursor_y >> 1) - 8);
+  vm_write_var(VAR_SCENE_CURSOR_X, ((INPUT_FRAME_CURSOR_X2 + (camera_fine_x >> 1)) >> 2) + camera_offset);
+  vm_write_var(VAR_SCENE_CURSOR_Y, (input_frame_cursor_y >> 1) - 8);
 
   // keyboard handling
   if (current_key_pressed) {
@@ -1650,27 +1885,24 @@ static void handle_input(void)
       // handle space key, pause
       //static const char pause_str[] = "Game paused, press SPACE to continue.";
 
-      input_key_pressed = 0; // ack the space key
       MAP_CS_GFX
       UNMAP_DS
       gfx_print_interface_text(0, 18, ui_strings[UI_STR_PAUSED], prev_sentence_highlighted ? TEXT_STYLE_HIGHLIGHTED : TEXT_STYLE_SENTENCE);
       script_watchdog = WATCHDOG_TIMEOUT;
 
-      while (1) {
-        if (input_key_pressed) {
-          if (input_key_pressed == 0x20) {
-            wait_for_jiffy();  // this resets the elapsed jiffies timer
-            break;
-          }
-          else {
-            // ack all other key presses
-            input_key_pressed = 0;
-          }
-        }
-      }
+      // ignore all other key presses
+      while (wait_for_key() != 0x20);
+      wait_for_jiffy();  // this resets the elapsed jiffies timer
       
       vm_print_sentence();
     }
+#if REPLAY == REPLAY_RECORD
+    else if (current_key_pressed == REPLAY_KEY_SAVE) {
+      // handle F7 key, save the recorded session
+      replay_save();
+      wait_for_jiffy(); // this resets the elapsed jiffies timer
+    }
+#endif
     else if (current_key_pressed == 0x1f) {
       // handle HELP key
       show_helpscreen();
@@ -1678,8 +1910,6 @@ static void handle_input(void)
     }
     else if (current_key_pressed == 8) {
       // handle restart key, ask user confirmation
-      input_key_pressed = 0; // ack the F8 restart key
-
       if (actor_talking != 0xff) {
         actor_stop_talking(actor_talking);
       }
@@ -1688,17 +1918,11 @@ static void handle_input(void)
       gfx_print_dialog(2, ui_strings[UI_STR_RESTART], strlen(ui_strings[UI_STR_RESTART]));
       script_watchdog = WATCHDOG_TIMEOUT;
       
-      while (1) {
-        if (input_key_pressed) {
-          if (input_key_pressed == restart_key_yes) {
-            reset_game = RESET_RESTART;
-            break;
-          }
-          else {
-            wait_for_jiffy();  // this resets the elapsed jiffies timer
-            break;
-          }
-        }
+      if (wait_for_key() == restart_key_yes) {
+        reset_game = RESET_RESTART;
+      }
+      else {
+        wait_for_jiffy();  // this resets the elapsed jiffies timer
       }
       
       gfx_clear_dialog();
@@ -1732,8 +1956,6 @@ static void handle_input(void)
       }
     }
     UNMAP_CS
-    // ack the key press
-    input_key_pressed = 0;
     // no further processing of joystick/mouse input as those might have happened as phantom input of key presses
     return;
   }
@@ -1745,13 +1967,13 @@ static void handle_input(void)
 
     if (current_button_pressed == INPUT_BUTTON_LEFT)
     {
-      if (input_cursor_y >= 16 && input_cursor_y < 144) {
+      if (input_frame_cursor_y >= 16 && input_frame_cursor_y < 144) {
         // clicked in gfx scene
         vm_write_var(VAR_INPUT_EVENT, INPUT_EVENT_SCENE_CLICK);
         script_start(SCRIPT_ID_INPUT_EVENT);
         return;
       }
-      else if (input_cursor_y >= 18 * 8 && input_cursor_y < 19 * 8) {
+      else if (input_frame_cursor_y >= 18 * 8 && input_frame_cursor_y < 19 * 8) {
         // clicked on sentence line
         if (ui_state & UI_FLAGS_ENABLE_SENTENCE) {
           vm_write_var(VAR_INPUT_EVENT, INPUT_EVENT_SENTENCE_CLICK);
@@ -1759,7 +1981,7 @@ static void handle_input(void)
           return;
         }
       }
-      else if (input_cursor_y >= 19 * 8 && input_cursor_y < 22 * 8) {
+      else if (input_frame_cursor_y >= 19 * 8 && input_frame_cursor_y < 22 * 8) {
         // clicked in verb zone
         if (ui_state & UI_FLAGS_ENABLE_VERBS) {
           MAP_CS_MAIN_PRIV
@@ -1771,7 +1993,7 @@ static void handle_input(void)
           return;
         }
       }
-      else if (input_cursor_y >= 22 * 8 && input_cursor_y < 24 * 8) {
+      else if (input_frame_cursor_y >= 22 * 8 && input_frame_cursor_y < 24 * 8) {
         // clicked in inventory zone
         if (ui_state & UI_FLAGS_ENABLE_INVENTORY) {
           select_inventory(get_hovered_inventory_slot());
@@ -1783,15 +2005,11 @@ static void handle_input(void)
 
 static uint8_t match_parent_object_state(uint8_t parent, uint8_t expected_state)
 {
-  SAVE_DS_AUTO_RESTORE
-  map_ds_resource(obj_page[parent]);
-
-  __auto_type obj_hdr  = (struct object_code *)NEAR_U8_PTR(RES_MAPPED + obj_offset[parent]);
-  uint8_t new_parent   = obj_hdr->parent;
-  uint8_t cur_state    = vm_state.global_game_objects[obj_hdr->id] & OBJ_STATE;
-  uint8_t parent_state = obj_hdr->pos_y_and_parent_state & 0x80;
+  uint8_t new_parent   = room_objects.parent[parent];
+  uint8_t cur_state    = vm_state.global_game_objects[obj_id[parent]] & OBJ_STATE;
+  uint8_t parent_state = room_objects.pos_y_and_parent_state[parent] & 0x80;
 
-  //debug_out("  check parent %d state %d - expected_state %d", obj_hdr->id, cur_state, expected_state);
+  //debug_out("  check parent %d state %d - expected_state %d", obj_id[parent], cur_state, expected_state);
 
   if (cur_state != expected_state) {
     return 0;
@@ -1804,24 +2022,104 @@ static uint8_t match_parent_object_state(uint8_t parent, uint8_t expected_state)
   return match_parent_object_state(new_parent - 1, parent_state);
 }
 
+/**
+  * @brief Advances the wait timers of all sleeping scripts
+  *
+  * Elapsed jiffies are only accumulated in timer_pending_jiffies. The wait timers of the
+  * sleeping slots are updated only once enough jiffies are pending for the earliest slot
+  * to wake up, so sleeping scripts cost nothing per frame until then.
+  *
+  * @param elapsed_jiffies The number of jiffies elapsed since the last call
+  *
+  * Code section: code_main
+  */
 static void update_script_timers(uint8_t elapsed_jiffies)
 {
   if (!ntsc) {
     ++elapsed_jiffies;
   }
-  for (uint8_t slot = 0; slot < NUM_SCRIPT_SLOTS; ++slot)
+  if (!num_sleeping_slots) {
+    return;
+  }
+  timer_pending_jiffies += elapsed_jiffies;
+  if (timer_pending_jiffies >= timer_next_wakeup) {
+    flush_script_timers();
+  }
+}
+
+/**
+  * @brief Applies the pending jiffies to the wait timers of all sleeping scripts
+  *
+  * Slots with a positive timer afterwards are set running again and leave the list of
+  * sleeping slots, as do slots which are not waiting for their timer anymore. Frozen slots
+  * keep their timer. The earliest wakeup of the remaining unfrozen slots is recalculated.
+  *
+  * Needs to be called before freezing or unfreezing slots and before the timers are saved,
+  * so frozen slots don't get jiffies applied that elapsed while they were unfrozen and vice
+  * versa. As pending jiffies never reach the next wakeup outside of update_script_timers,
+  * this will never wake up a script. After unfreezing, timer_next_wakeup needs to be reset to
+  * 0, so the next update includes the unfrozen slots in the earliest wakeup.
+  *
+  * Code section: code_main
+  */
+static void flush_script_timers(void)
+{
+  int32_t next_wakeup = INT32_MAX;
+  uint8_t num_sleeping = 0;
+
+  for (uint8_t i = 0; i < num_sleeping_slots; ++i)
   {
+    uint8_t slot  = sleeping_slots[i];
+    uint8_t state = vm_state.proc_state[slot];
+    if ((state & 0x07) != PROC_STATE_WAITING_FOR_TIMER) {
+      continue;
+    }
     // checking for equality will also make sure we won't update slots that are frozen
-    if (vm_state.proc_state[slot] == PROC_STATE_WAITING_FOR_TIMER)
+    if (state == PROC_STATE_WAITING_FOR_TIMER)
     {
-      vm_state.proc_wait_timer[slot] += elapsed_jiffies;
-      //uint8_t timer_msb = (uint8_t)((uintptr_t)(vm_state.proc_wait_timer[slot]) >> 24);
-      //if (timer_msb == 0)
-      if (vm_state.proc_wait_timer[slot] > 0)
+      int32_t timer = vm_state.proc_wait_timer[slot] + timer_pending_jiffies;
+      vm_state.proc_wait_timer[slot] = timer;
+      if (timer > 0)
       {
         set_proc_state(slot, PROC_STATE_RUNNING);
+        continue;
+      }
+      if (1 - timer < next_wakeup) {
+        next_wakeup = 1 - timer;
       }
     }
+    sleeping_slots[num_sleeping++] = slot;
+  }
+
+  num_sleeping_slots    = num_sleeping;
+  timer_pending_jiffies = 0;
+  timer_next_wakeup     = next_wakeup;
+}
+
+/**
+  * @brief Rebuilds the list of sleeping scripts from the script slot states
+  *
+  * Used after the slot states got reset or loaded from a savegame. Slots waiting for an event
+  * are set running again, as the events they were waiting for are not saved. They will check
+  * their wait condition again and wait for the event anew if needed.
+  *
+  * Code section: code_main
+  */
+static void reset_script_timers(void)
+{
+  num_sleeping_slots    = 0;
+  timer_pending_jiffies = 0;
+  timer_next_wakeup     = 0;  // next update recalculates the earliest wakeup
+  num_event_waits       = 0;
+  for (uint8_t slot = 0; slot < NUM_SCRIPT_SLOTS; ++slot)
+  {
+    uint8_t state = vm_state.proc_state[slot] & 0x07;
+    if (state == PROC_STATE_WAITING_FOR_TIMER) {
+      sleeping_slots[num_sleeping_slots++] = slot;
+    }
+    else if (state == PROC_STATE_WAITING_FOR_EVENT) {
+      set_proc_state(slot, PROC_STATE_RUNNING);
+    }
   }
 }
 
@@ -1835,10 +2133,11 @@ static const char *get_object_name(uint16_t global_object_id)
   
   if (owner == 0x0f) {
     // is room object
-    struct object_code *obj_hdr = obj_hdr = vm_get_room_object_hdr(global_object_id);
-    if (obj_hdr) {
-      uint16_t name_offset = obj_hdr->name_offset;
-      return ((const char *)obj_hdr) + name_offset;
+    uint8_t local_id = vm_get_local_object_id(global_object_id);
+    if (local_id != 0xff) {
+      map_ds_resource(obj_page[local_id]);
+      uint16_t name_offset = obj_offset[local_id] + room_objects.name_offset[local_id];
+      return (const char *)NEAR_U8_PTR(RES_MAPPED + name_offset);
     }
   }
   else if (owner == vm_read_var8(VAR_SELECTED_ACTOR)) {
@@ -1951,10 +2250,13 @@ static void animate_actors(void)
 static void override_cutscene(void)
 {
   if (vm_state.cs_override_pc) {
+    flush_script_timers();
     vm_state.proc_pc[vm_state.cs_proc_slot] = vm_state.cs_override_pc;
     vm_state.cs_override_pc = 0;
     vm_state.proc_state[vm_state.cs_proc_slot] &= ~PROC_FLAGS_FROZEN;
-    if (vm_state.proc_state[vm_state.cs_proc_slot] == PROC_STATE_WAITING_FOR_TIMER) {
+    timer_next_wakeup = 0; // the unfrozen slot was not part of the earliest wakeup
+    if (vm_state.proc_state[vm_state.cs_proc_slot] == PROC_STATE_WAITING_FOR_TIMER ||
+        vm_state.proc_state[vm_state.cs_proc_slot] == PROC_STATE_WAITING_FOR_EVENT) {
       vm_state.proc_state[vm_state.cs_proc_slot] = PROC_STATE_RUNNING;
     }
     vm_write_var(VAR_OVERRIDE_HIT, 1);
@@ -1979,7 +2281,7 @@ static void update_sentence_highlighting(void)
     return;
   }
 
-  if (input_cursor_y >= 18 * 8 && input_cursor_y < 19 * 8) {
+  if (input_frame_cursor_y >= 18 * 8 && input_frame_cursor_y < 19 * 8) {
     if (!prev_sentence_highlighted) {
       MAP_CS_GFX
       gfx_change_interface_text_style(0, 18, 40, TEXT_STYLE_HIGHLIGHTED);
@@ -2026,7 +2328,7 @@ static void update_verb_highlighting(void)
   }
 
   uint8_t cur_verb = 0xff;
-  if (input_cursor_y >= 19 * 8 && input_cursor_y < 22 * 8) {
+  if (input_frame_cursor_y >= 19 * 8 && input_frame_cursor_y < 22 * 8) {
     MAP_CS_MAIN_PRIV
     cur_verb = get_hovered_verb_slot();
   }
@@ -2162,17 +2464,17 @@ static uint8_t get_hovered_inventory_slot(void)
 {
   uint8_t cur_inventory = 0xff;
   
-  if (input_cursor_y >= 22 * 8 && input_cursor_y < 24 * 8) {
-    if (INPUT_CURSOR_X2 >= 22 * 4) {
+  if (input_frame_cursor_y >= 22 * 8 && input_frame_cursor_y < 24 * 8) {
+    if (INPUT_FRAME_CURSOR_X2 >= 22 * 4) {
       cur_inventory = 1;
     }
-    else if (INPUT_CURSOR_X2 < 18 * 4) {
+    else if (INPUT_FRAME_CURSOR_X2 < 18 * 4) {
       cur_inventory = 0;
     }
     else {
       cur_inventory = 4;
     }
-    if (cur_inventory != 0xff && input_cursor_y >= 23 * 8) {
+    if (cur_inventory != 0xff && input_frame_cursor_y >= 23 * 8) {
       cur_inventory += cur_inventory < 4 ? 2 : 1;
     }
   }
@@ -2318,6 +2620,7 @@ static void read_walk_boxes(void)
     //debug_out("  classes: %x", box->classes);
   }
   walk_box_matrix = box_ptr;
+  walkbox_build_lines_table();
   /*
   for (uint8_t i = 0; i < num_walk_boxes; ++i) {
     debug_out("  row offset %d = %d", i, *box_ptr++);
@@ -2342,15 +2645,11 @@ static void read_walk_boxes(void)
   */
 static void clear_all_other_object_states(uint8_t local_object_id)
 {
-  SAVE_DS_AUTO_RESTORE
-
-  map_ds_resource(obj_page[local_object_id]);
-  __auto_type obj_hdr = (struct object_code *)(RES_MAPPED + obj_offset[local_object_id]);
-  uint8_t width = obj_hdr->width;
-  uint8_t height = obj_hdr->height_and_actor_dir >> 3;
-  uint8_t x = obj_hdr->pos_x;
-  uint8_t y = obj_hdr->pos_y_and_parent_state & 0x7f;
-  uint16_t global_object_id = obj_hdr->id;
+  uint8_t width = room_objects.width[local_object_id];
+  uint8_t height = room_objects.height[local_object_id];
+  uint8_t x = room_objects.pos_x[local_object_id];
+  uint8_t y = room_objects.pos_y_and_parent_state[local_object_id] & 0x7f;
+  uint16_t global_object_id = obj_id[local_object_id];
 
   for (uint8_t i = 0; i < num_objects; ++i)
   {
@@ -2359,26 +2658,56 @@ static void clear_all_other_object_states(uint8_t local_object_id)
       continue;
     }
 
-    map_ds_resource(obj_page[i]);
-    __auto_type obj_hdr = (struct object_code *)(RES_MAPPED + obj_offset[i]);
-    if (obj_hdr->width == width && 
-       (obj_hdr->height_and_actor_dir >> 3) == height &&
-        obj_hdr->pos_x == x && 
-       (obj_hdr->pos_y_and_parent_state & 0x7f) == y)
+    if (room_objects.width[i] == width && 
+        room_objects.height[i] == height &&
+        room_objects.pos_x[i] == x && 
+       (room_objects.pos_y_and_parent_state[i] & 0x7f) == y)
     {
-      vm_state.global_game_objects[obj_hdr->id] &= ~OBJ_STATE;
+      vm_state.global_game_objects[obj_id[i]] &= ~OBJ_STATE;
       // since actors could potentially be affected, we need to redraw those as well
       vm_update_actors();
-      //debug_out("Cleared state of object %d due to identical position and size", obj_hdr->id);
+      //debug_out("Cleared state of object %d due to identical position and size", obj_id[i]);
     }
   }
 }
 
+/**
+  * @brief Moves the camera towards the nearest char column if it stopped in between
+  *
+  * camera_fine_x must get back to zero whenever the camera stops moving, otherwise the
+  * background stays shifted by a sub-char offset. The camera keeps scrolling by
+  * CAMERA_SCROLL_STEP per frame until it reaches the column, so neither the view nor the
+  * room position of the cursor (VAR_SCENE_CURSOR_X) jumps.
+  *
+  * Code section: code_main_private
+  */
+static void align_camera_to_char(void)
+{
+  if (!camera_fine_x) {
+    return;
+  }
+
+  uint16_t camera_pos = camera_x * 8 + camera_fine_x;
+  if (camera_fine_x >= 4) {
+    camera_pos += CAMERA_SCROLL_STEP;
+  }
+  else {
+    camera_pos -= CAMERA_SCROLL_STEP;
+  }
+  camera_x      = camera_pos >> 3;
+  camera_fine_x = camera_pos & 7;
+
+  vm_write_var(VAR_CAMERA_X, camera_x);
+  screen_update_needed |= SCREEN_UPDATE_SCROLL;
+  vm_update_actors();
+}
+
 static void update_camera(void)
 {
   if (camera_state == CAMERA_STATE_FOLLOW_ACTOR && camera_follow_actor_id == 0xff)
   {
     camera_state = 0;
+    align_camera_to_char();
     return;
   }
 
@@ -2396,27 +2725,34 @@ static void update_camera(void)
   }
   else
   {
+    align_camera_to_char();
     return;
   }
 
+  // camera movement is done in pixels, camera_fine_x is only non-zero while moving
+  uint16_t camera_pos = camera_x * 8 + camera_fine_x;
+  uint16_t target_pos = camera_target * 8;
+
   if (camera_state & CAMERA_STATE_MOVING) {
-    if (camera_target > camera_x) {
+    if (target_pos > camera_pos) {
       //debug_msg("Camera continue moving right");
-      if (camera_x < max_camera_x) {
-        camera_x += 1;
+      if (camera_pos < max_camera_x * 8) {
+        camera_pos += CAMERA_SCROLL_STEP;
       }
       else {
         camera_state &= ~CAMERA_STATE_MOVING;
+        align_camera_to_char();
         return;
       }
     }
-    else if (camera_target < camera_x) {
+    else if (target_pos < camera_pos) {
       //debug_msg("Camera continue moving left");
-      if (camera_x > 20) {
-        camera_x -= 1;
+      if (camera_pos > 20 * 8) {
+        camera_pos -= CAMERA_SCROLL_STEP;
       }
       else {
         camera_state &= ~CAMERA_STATE_MOVING;
+        align_camera_to_char();
         return;
       }
     }
@@ -2433,33 +2769,37 @@ static void update_camera(void)
     if (camera_target < camera_x - 10 && camera_x > 20)
     {
       //debug_msg("Camera start moving left");
-      --camera_x;
+      camera_pos -= CAMERA_SCROLL_STEP;
       camera_state |= CAMERA_STATE_MOVING;
     }
     else if (camera_target > camera_x + 10 && camera_x < max_camera_x)
     {
       //debug_msg("Camera start moving right");
-      ++camera_x;
+      camera_pos += CAMERA_SCROLL_STEP;
       camera_state |= CAMERA_STATE_MOVING;
     }
     else {
+      align_camera_to_char();
       return;
     }
   }
 
+  camera_x      = camera_pos >> 3;
+  camera_fine_x = camera_pos & 7;
+
   if (camera_x != old_camera_x) {
     vm_write_var(VAR_CAMERA_X, camera_x);
     //debug_out("camera_x: %d", camera_x);
-    vm_update_bg();
-    vm_update_actors();
   }
+  screen_update_needed |= SCREEN_UPDATE_SCROLL;
+  vm_update_actors();
 }
 
 static uint8_t get_hovered_verb_slot(void)
 {
-  uint8_t row = input_cursor_y >> 3;
+  uint8_t row = input_frame_cursor_y >> 3;
   for (uint8_t i = 0; i < MAX_VERBS; ++i) {
-    uint8_t col = INPUT_CURSOR_X2 >> 2;
+    uint8_t col = INPUT_FRAME_CURSOR_X2 >> 2;
     if (vm_state.verbs.id[i] != 0xff) {
       if (row == vm_state.verbs.y[i] && col >= vm_state.verbs.x[i] && col < vm_state.verbs.x[i] + vm_state.verbs.len[i]) {
         return i;
@@ -2526,6 +2866,7 @@ static void verb_delete(uint8_t slot)
 
 static void freeze_non_active_scripts(void)
 {
+  flush_script_timers();
   for (uint8_t slot = 0; slot < NUM_SCRIPT_SLOTS; ++slot) {
     if (slot != active_script_slot && vm_state.proc_state[slot] != PROC_STATE_FREE) {
       vm_state.proc_state[slot] |= PROC_FLAGS_FROZEN;
@@ -2535,9 +2876,12 @@ static void freeze_non_active_scripts(void)
 
 static void unfreeze_scripts(void)
 {
+  flush_script_timers();
   for (uint8_t slot = 0; slot < NUM_SCRIPT_SLOTS; ++slot) {
     vm_state.proc_state[slot] &= ~PROC_FLAGS_FROZEN;
   }
+  // unfrozen slots were not part of the earliest wakeup, next update recalculates it
+  timer_next_wakeup = 0;
 }
 
 static void add_string_to_sentence_priv(const char *str, uint8_t prepend_space)
@@ -2585,13 +2929,13 @@ static uint8_t resolve_position(uint16_t object_or_actor_id, uint8_t *x, uint8_t
   }
 
   // is room object
-  __auto_type obj_hdr = vm_get_room_object_hdr(object_or_actor_id);
-  if (!obj_hdr) {
+  uint8_t local_id = vm_get_local_object_id(object_or_actor_id);
+  if (local_id == 0xff) {
     *room_id = 0xff;
   } 
   else {
-    *x       = obj_hdr->walk_to_x;
-    *y       = (obj_hdr->walk_to_y_and_preposition & 0x1f) << 2;
+    *x       = room_objects.walk_to_x[local_id];
+    *y       = (room_objects.walk_to_y_and_preposition[local_id] & 0x1f) << 2;
     *room_id = vm_read_var(VAR_SELECTED_ROOM);
   }
   return 0;
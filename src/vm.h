@@ -28,6 +28,9 @@
 #define MAX_INVENTORY        80
 #define CMD_STACK_SIZE        6
 #define WATCHDOG_TIMEOUT     30
+#define OBJ_BUCKET_SHIFT      4  // object hit-test buckets are 16 chars wide
+#define NUM_OBJ_BUCKETS      16
+#define OBJ_BUCKET_BYTES     ((MAX_OBJECTS + 7) / 8)
 
 enum {
   LANG_EN,
@@ -41,10 +44,16 @@ enum {
   PROC_STATE_RUNNING           = 1,
   PROC_STATE_WAITING_FOR_TIMER = 2,
   PROC_STATE_WAITING_FOR_CHILD = 3,
+  PROC_STATE_WAITING_FOR_EVENT = 4,
   // flags (bits 3-7)
   PROC_FLAGS_FROZEN            = 0x80
 };
 
+// events scripts can wait for, values below NUM_ACTORS signal that the actor stopped walking
+enum {
+  EVENT_MESSAGE_DONE = 0xff
+};
+
 enum {
   PROC_TYPE_GLOBAL       = 0x01,
   PROC_TYPE_BACKGROUND   = 0x02,
@@ -120,9 +129,26 @@ enum {
   SCREEN_UPDATE_DIALOG     = 0x08,
   SCREEN_UPDATE_VERBS      = 0x10,
   SCREEN_UPDATE_SENTENCE   = 0x20,
-  SCREEN_UPDATE_INVENTORY  = 0x40
+  SCREEN_UPDATE_INVENTORY  = 0x40,
+  SCREEN_UPDATE_SCROLL     = 0x80
 };
 
+// Number of pixels the camera moves per frame while panning. Needs to be 1, 2, 4 or 8.
+// A value of 8 reproduces the original char-by-char camera movement. Smaller values give
+// smooth sub-char panning, but the camera still moves once per frame, so panning gets
+// slower and scripts waiting for the camera see different timing. Enable by building with
+// e.g. CC_FLAGS+=-DCAMERA_SCROLL_STEP=2.
+#ifndef CAMERA_SCROLL_STEP
+#define CAMERA_SCROLL_STEP 8
+#endif
+
+// Number of opcodes per frame after which background object scripts are suspended until the
+// next frame. Other scripts are not limited, but their opcodes count towards the budget.
+// A value of 0 disables the limit and reproduces the original script timing.
+#ifndef BACKGROUND_OPCODE_BUDGET
+#define BACKGROUND_OPCODE_BUDGET 0
+#endif
+
 enum {
   UI_FLAGS_APPLY_FREEZE     = 0x01,
 	UI_FLAGS_APPLY_CURSOR     = 0x02,
@@ -168,6 +194,19 @@ struct object_code {
   uint8_t  name_offset;
 };
 
+// cached header fields of the objects in the current room, filled in by read_objects
+typedef struct {
+  uint8_t       pos_x[MAX_OBJECTS];
+  uint8_t       pos_y_and_parent_state[MAX_OBJECTS];
+  uint8_t       width[MAX_OBJECTS];
+  uint8_t       height[MAX_OBJECTS];
+  uint8_t       parent[MAX_OBJECTS];
+  uint8_t       walk_to_x[MAX_OBJECTS];
+  uint8_t       walk_to_y_and_preposition[MAX_OBJECTS];
+  uint8_t       actor_dir[MAX_OBJECTS];
+  uint8_t       name_offset[MAX_OBJECTS];
+} room_objects_t;
+
 struct vm
 {
   uint8_t global_game_objects[780];
@@ -213,11 +252,15 @@ extern uint8_t          reset_game;
 extern uint8_t          proc_slot_table_exec;
 extern char             message_buffer[256];
 extern volatile uint8_t script_watchdog;
+#if BACKGROUND_OPCODE_BUDGET
+extern uint16_t         frame_opcode_count;
+#endif
 extern uint8_t          ui_state;
 extern uint16_t         camera_x;
+extern uint8_t          camera_fine_x;
 extern int8_t           proc_slot_table_idx;
 extern uint8_t          proc_table_cleanup_needed;
-extern uint8_t          active_script_slot;
+extern uint8_t __attribute__((zpage)) active_script_slot;
 extern uint8_t          proc_res_slot[NUM_SCRIPT_SLOTS];
 extern uint8_t          proc_exec_count[NUM_SCRIPT_SLOTS];
 extern uint8_t          lang;
@@ -226,6 +269,7 @@ extern uint8_t          room_res_slot;
 extern uint8_t          obj_page[MAX_OBJECTS];
 extern uint8_t          obj_offset[MAX_OBJECTS];
 extern uint16_t         obj_id[MAX_OBJECTS];
+extern room_objects_t   room_objects;
 extern uint8_t          ntsc;
 extern uint8_t          inventory_pos;
 extern uint8_t          last_selected_actor;
@@ -246,6 +290,8 @@ void vm_change_ui_flags(uint8_t flags);
 void vm_set_current_room(uint8_t room_no);
 uint8_t vm_get_room_object_script_offset(uint8_t verb, uint8_t local_object_id, uint8_t is_inventory);
 void vm_set_script_wait_timer(int32_t negative_ticks);
+void vm_wait_for_event(uint8_t event);
+void vm_signal_event(uint8_t event);
 void vm_cut_scene_begin(void);
 void vm_cut_scene_end(void);
 void vm_begin_override(void);
@@ -293,6 +339,17 @@ static inline uint8_t vm_read_var8(uint8_t var)
   return vm_state.variables_lo[var];
 }
 
+static inline uint8_t vm_is_var_zero(uint8_t var)
+{
+  return !(vm_state.variables_lo[var] | vm_state.variables_hi[var]);
+}
+
+static inline void vm_write_var8(uint8_t var, uint8_t value)
+{
+  vm_state.variables_lo[var] = value;
+  vm_state.variables_hi[var] = 0;
+}
+
 static inline void vm_write_var(uint8_t var, uint16_t value)
 {
   vm_state.variables_lo[var] = LSB(value);
@@ -19,6 +19,8 @@
 
 #include "walk_box.h"
 #include "map.h"
+#include "memory.h"
+#include "resource.h"
 #include "util.h"
 #include "vm.h"
 #include <stdlib.h>
@@ -30,10 +32,13 @@
 uint8_t          num_walk_boxes;
 struct walk_box *walk_boxes;
 uint8_t         *walk_box_matrix;
+uint8_t          walk_box_table_slot = 0xff;
+uint8_t          walk_box_lock_gen;    // incremented whenever a box gets locked or unlocked
 
 //----------------------------------------------------------------------------------------------
 
 // private functions
+static uint16_t get_corrected_box_position(struct walk_box_lines *box, uint8_t *x, uint8_t *y);
 static uint8_t binary_search_xy(uint8_t x1, uint8_t x2, uint8_t y1, uint8_t y2, uint8_t yc);
 static void find_closest_point_on_line(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t *x, uint8_t *y);
 
@@ -74,20 +79,51 @@ uint8_t walkbox_get_box_classes(uint8_t box_id)
   return classes;
 }
 
-uint8_t walkbox_correct_position_to_closest_box(uint8_t *x, uint8_t *y)
+/**
+  * @brief Sets the classes of a walk box.
+  *
+  * The classes are updated in the room resource as well as in the precomputed walk box table.
+  *
+  * @param box_id The id of the walk box.
+  * @param classes The new classes of the walk box.
+  */
+void walkbox_set_box_classes(uint8_t box_id, uint8_t classes)
 {
   SAVE_DS_AUTO_RESTORE
   map_ds_resource(room_res_slot);
+  if ((walk_boxes[box_id].classes ^ classes) & WALKBOX_CLASS_BOX_LOCKED) {
+    // invalidates all precomputed actor routes
+    ++walk_box_lock_gen;
+  }
+  walk_boxes[box_id].classes = classes;
+  map_ds_resource(walk_box_table_slot);
+  ((struct walk_box_lines *)RES_MAPPED)[box_id].classes = classes;
+}
+
+/**
+  * @brief Moves a position into the closest visible walk box.
+  *
+  * Uses the precomputed walk box table, so each box is checked by a lookup of the x bounds
+  * of the box scanline closest to the position.
+  *
+  * @param x The x-coordinate of the position, will be updated with the corrected position.
+  * @param y The y-coordinate of the position, will be updated with the corrected position.
+  * @return The id of the walk box the position was moved into.
+  */
+uint8_t walkbox_correct_position_to_closest_box(uint8_t *x, uint8_t *y)
+{
+  SAVE_DS_AUTO_RESTORE
+  map_ds_resource(walk_box_table_slot);
 
   uint16_t min_distance = 0xffff;
   uint8_t corr_pos_x;
   uint8_t corr_pos_y;
   uint8_t dest_walk_box;
   int8_t box_idx;
-  struct walk_box *walk_box;
+  struct walk_box_lines *walk_box;
 
   //debug_out("Correct pos %d, %d", *x, *y);
-  for (box_idx = num_walk_boxes - 1, walk_box = &walk_boxes[num_walk_boxes - 1]; box_idx >= 0; --box_idx, --walk_box) {
+  for (box_idx = num_walk_boxes - 1, walk_box = (struct walk_box_lines *)RES_MAPPED + num_walk_boxes - 1; box_idx >= 0; --box_idx, --walk_box) {
     // skip invisible walk boxes when determining a point within one of the available walk boxes
     if (walk_box->classes & WALKBOX_CLASS_BOX_INVISIBLE) {
       continue;
@@ -95,7 +131,7 @@ uint8_t walkbox_correct_position_to_closest_box(uint8_t *x, uint8_t *y)
     uint8_t walk_box_x = *x;
     uint8_t walk_box_y = *y;
     //debug_out("Checking box %d", box_idx);
-    uint16_t distance = walkbox_get_corrected_box_position(walk_box, &walk_box_x, &walk_box_y);
+    uint16_t distance = get_corrected_box_position(walk_box, &walk_box_x, &walk_box_y);
     //debug_out(" box %d w_x,y: %d, %d d %d", box_idx, walk_box_x, walk_box_y, distance);
     if (distance == 0) {
       //debug_out("  inside box");
@@ -119,76 +155,6 @@ uint8_t walkbox_correct_position_to_closest_box(uint8_t *x, uint8_t *y)
   return dest_walk_box;
 }
 
-uint16_t walkbox_get_corrected_box_position(struct walk_box *box, uint8_t *x, uint8_t *y)
-{
-  uint8_t xc = *x;
-  uint8_t yc = *y;
-  uint8_t yn;
-  uint8_t x_left;
-  uint8_t x_right;
-  uint8_t y_top = box->top_y;
-  uint8_t y_bottom = box->bottom_y;
-
-  if (yc >= y_bottom) {
-    //debug_out("  below box");
-    yc = y_bottom;
-    x_left = box->bottomleft_x;
-    x_right = box->bottomright_x;
-  }
-  else if (yc < y_top) {
-    //debug_out("  above box");
-    yc = y_top;
-    x_left = box->topleft_x;
-    x_right = box->topright_x;
-  }
-  else if (xc < box->topleft_x || xc < box->bottomleft_x) {
-    //debug_out("  left of box");
-    SAVE_CS
-    MAP_CS_MAIN_PRIV
-    x_left = binary_search_xy(box->topleft_x, box->bottomleft_x, box->top_y, box->bottom_y, yc);
-    x_right = xc;
-    RESTORE_CS
-  }
-  else if (xc > box->topright_x || xc > box->bottomright_x) {
-    //debug_out("  right of box");
-    SAVE_CS
-    MAP_CS_MAIN_PRIV
-    x_left = xc;
-    x_right = binary_search_xy(box->topright_x, box->bottomright_x, box->top_y, box->bottom_y, yc);
-    RESTORE_CS
-  }
-  else {
-    // in this case the point is inside the rectangle that is defined by the inner points of the box
-    //debug_out("  inside box");
-    x_left  = max(box->topleft_x, box->bottomleft_x);
-    x_right = min(box->topright_x, box->bottomright_x);
-  }
-
-  if (xc < x_left) {
-    xc = x_left;
-  }
-  else if (xc > x_right) {
-    xc = x_right;
-  }
-
-  //debug_out("  corrected position %d, %d", xc, yc);
-
-  uint8_t diff_x = abs8((int8_t)xc - (int8_t)*x);
-  uint8_t diff_y = abs8((int8_t)yc - (int8_t)*y) >> 2;
-  //debug_out("  diff %d, %d", diff_x, diff_y);
-  if (diff_x < diff_y) {
-    diff_x >>= 1;
-  }
-  else {
-    diff_y >>= 1;
-  }
-
-  *x = xc;
-  *y = yc;
-
-  return diff_x + diff_y;
-}
-
 /**
   * @brief Find the closest point on the perimeter of a walk box to a given point.
   * 
@@ -242,10 +208,136 @@ void walkbox_find_closest_box_point(uint8_t box_id, uint8_t *px, uint8_t *py)
 
 //----------------------------------------------------------------------------------------------
 
+/**
+  * @defgroup walkbox_room_setup Walk Box Room Setup Functions
+  * @{
+  */
+#pragma clang section text="code_main_private"
+
+/**
+  * @brief Builds the precomputed walk box table of the current room.
+  *
+  * For each walk box, the left and right x bounds of each scanline are calculated once,
+  * so that clamping a position to a box becomes a simple table lookup. The table is stored
+  * in a heap resource slot, which replaces the one of the previous room.
+  *
+  * Needs the room resource mapped to DS.
+  *
+  * Code section: code_main_private
+  */
+void walkbox_build_lines_table(void)
+{
+  if (walk_box_table_slot != 0xff) {
+    res_free_heap(walk_box_table_slot);
+    walk_box_table_slot = 0xff;
+  }
+
+  uint16_t table_size = num_walk_boxes * sizeof(struct walk_box_lines);
+  for (uint8_t i = 0; i < num_walk_boxes; ++i) {
+    table_size += (walk_boxes[i].bottom_y - walk_boxes[i].top_y + 1) * 2;
+  }
+  // round up to whole pages, but reserve at least one, so the table slot can always be mapped
+  uint8_t num_pages = (table_size + 255) >> 8;
+  walk_box_table_slot = res_reserve_heap(num_pages ? num_pages : 1);
+  map_ds_resource(room_res_slot);
+
+  __auto_type table      = res_get_huge_ptr(walk_box_table_slot);
+  __auto_type box_header = (struct walk_box_lines __huge *)table;
+  uint16_t    offset     = num_walk_boxes * sizeof(struct walk_box_lines);
+
+  for (uint8_t i = 0; i < num_walk_boxes; ++i) {
+    struct walk_box *box = &walk_boxes[i];
+    uint8_t top_y    = box->top_y;
+    uint8_t bottom_y = box->bottom_y;
+    box_header->top_y         = top_y;
+    box_header->bottom_y      = bottom_y;
+    box_header->classes       = box->classes;
+    box_header->bounds_offset = offset;
+    ++box_header;
+
+    __auto_type bounds = table + offset;
+    uint8_t y = top_y;
+    do {
+      uint8_t x_left;
+      uint8_t x_right;
+      if (y == top_y) {
+        x_left  = box->topleft_x;
+        x_right = box->topright_x;
+      }
+      else if (y == bottom_y) {
+        x_left  = box->bottomleft_x;
+        x_right = box->bottomright_x;
+      }
+      else {
+        x_left  = binary_search_xy(box->topleft_x, box->bottomleft_x, top_y, bottom_y, y);
+        x_right = binary_search_xy(box->topright_x, box->bottomright_x, top_y, bottom_y, y);
+      }
+      *bounds++ = x_left;
+      *bounds++ = x_right;
+      offset += 2;
+    }
+    while (y++ != bottom_y);
+  }
+}
+
+/** @} */ // walkbox_room_setup
+
+//----------------------------------------------------------------------------------------------
+
 /**
   * @defgroup walkbox_private Walk Box Private Functions
   * @{
   */
+#pragma clang section text="code_main"
+
+/**
+  * @brief Clamps a position to a walk box using the precomputed scanline bounds.
+  *
+  * @param box Pointer to the box header in the mapped walk box table.
+  * @param x The x-coordinate of the position, will be updated with the clamped position.
+  * @param y The y-coordinate of the position, will be updated with the clamped position.
+  * @return The weighted distance between the original and the clamped position.
+  *
+  * Code section: code_main
+  */
+static uint16_t get_corrected_box_position(struct walk_box_lines *box, uint8_t *x, uint8_t *y)
+{
+  uint8_t xc = *x;
+  uint8_t yc = *y;
+
+  if (yc >= box->bottom_y) {
+    yc = box->bottom_y;
+  }
+  else if (yc < box->top_y) {
+    yc = box->top_y;
+  }
+
+  __auto_type bounds = NEAR_U8_PTR(RES_MAPPED + box->bounds_offset + (uint8_t)(yc - box->top_y) * 2);
+  if (xc < bounds[0]) {
+    xc = bounds[0];
+  }
+  else if (xc > bounds[1]) {
+    xc = bounds[1];
+  }
+
+  //debug_out("  corrected position %d, %d", xc, yc);
+
+  uint8_t diff_x = abs8((int8_t)xc - (int8_t)*x);
+  uint8_t diff_y = abs8((int8_t)yc - (int8_t)*y) >> 2;
+  //debug_out("  diff %d, %d", diff_x, diff_y);
+  if (diff_x < diff_y) {
+    diff_x >>= 1;
+  }
+  else {
+    diff_y >>= 1;
+  }
+
+  *x = xc;
+  *y = yc;
+
+  return diff_x + diff_y;
+}
+
 #pragma clang section text="code_main_private"
 
 static uint8_t binary_search_xy(uint8_t x1, uint8_t x2, uint8_t y1, uint8_t y2, uint8_t yc)
@@ -32,6 +32,18 @@ struct walk_box {
   uint8_t classes;
 };
 
+/**
+  * Precomputed walk box data, built on room load. The table is stored in a heap resource
+  * slot and starts with one header per walk box, followed by the left and right x bounds
+  * of each scanline of each box (one pair per y coordinate from top_y to bottom_y).
+  */
+struct walk_box_lines {
+  uint8_t  top_y;
+  uint8_t  bottom_y;
+  uint8_t  classes;
+  uint16_t bounds_offset; // offset of the x bounds of the box's first scanline in the table
+};
+
 enum walk_box_class {
   WALKBOX_CLASS_BOX_LOCKED    = 0x40,
   WALKBOX_CLASS_BOX_INVISIBLE = 0x80
@@ -40,11 +52,16 @@ enum walk_box_class {
 extern uint8_t          num_walk_boxes;
 extern struct walk_box *walk_boxes;
 extern uint8_t         *walk_box_matrix;
+extern uint8_t          walk_box_table_slot;
+extern uint8_t          walk_box_lock_gen;
 
 // main functions
 uint8_t walkbox_get_next_box(uint8_t cur_box, uint8_t target_box);
 uint8_t walkbox_get_box_masking(uint8_t box_id);
 uint8_t walkbox_get_box_classes(uint8_t box_id);
+void walkbox_set_box_classes(uint8_t box_id, uint8_t classes);
 uint8_t walkbox_correct_position_to_closest_box(uint8_t *x, uint8_t *y);
-uint16_t walkbox_get_corrected_box_position(struct walk_box *box, uint8_t *x, uint8_t *y);
 void walkbox_find_closest_box_point(uint8_t box_id, uint8_t *px, uint8_t *py);
+
+// room setup functions (code_main_private)
+void walkbox_build_lines_table(void);